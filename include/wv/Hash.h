@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace WillowVox
+{
+    // 64-bit FNV-1a hash. constexpr, so hashes of literals can be computed at compile time
+    constexpr uint64_t Hash64(std::string_view data, uint64_t hash = 0xcbf29ce484222325ull)
+    {
+        for (char c : data)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+}
@@ -23,6 +23,9 @@ namespace WillowVox
         virtual void Update() {}
         // Runs at the end of every frame for custom rendering code
         virtual void Render() {}
+        // Runs after the last frame, while the GL context is still alive
+        // Stop or wait on jobs that use GPU resources here, e.g. ones writing into TextureStreamer regions
+        virtual void Shutdown() {}
 
         // Delta time between frames
         static float m_deltaTime;
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <wv/wvpch.h>
+#include <span>
+#include <string_view>
+
+namespace WillowVox
+{
+    // Packed asset archive layout, as written by the AssetPacker tool (little-endian):
+    //   ArchiveHeader
+    //   ArchiveEntry[entryCount], sorted by hash
+    //   File data, each file aligned to ARCHIVE_ALIGNMENT
+    struct ArchiveHeader
+    {
+        static constexpr uint32_t MAGIC = 0x4B505657; // "WVPK"
+        static constexpr uint32_t VERSION = 1;
+
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t reserved;
+    };
+
+    struct ArchiveEntry
+    {
+        // Hash64 of the path relative to the assets directory, with '/' separators (e.g. "textures/grass.png")
+        uint64_t hash;
+        // Offset from the start of the archive
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    constexpr uint64_t ARCHIVE_ALIGNMENT = 16;
+
+    // Identifies a version of an asset file, e.g. to tell whether data derived from it is stale
+    struct AssetFileInfo
+    {
+        uint64_t size = 0;
+        // Last write time of the file, or of the archive it is in. Only meaningful to compare for equality
+        int64_t modifiedTime = 0;
+    };
+
+    // Bytes of an asset file
+    // Points straight into a mounted archive, or owns the bytes read from a loose file
+    class AssetFile
+    {
+    public:
+        AssetFile() = default;
+        explicit AssetFile(std::span<const unsigned char> data) : m_data(data) {}
+        explicit AssetFile(std::vector<unsigned char> data) : m_owned(std::move(data)), m_data(m_owned) {}
+
+        // The span points into m_owned, so copying would leave it pointing at the original
+        AssetFile(const AssetFile&) = delete;
+        AssetFile& operator=(const AssetFile&) = delete;
+        AssetFile(AssetFile&&) = default;
+        AssetFile& operator=(AssetFile&&) = default;
+
+        std::span<const unsigned char> GetData() const { return m_data; }
+        explicit operator bool() const { return m_data.data() != nullptr; }
+
+    private:
+        std::vector<unsigned char> m_owned;
+        std::span<const unsigned char> m_data;
+    };
+
+    // A packed asset archive mapped into memory
+    class AssetArchive
+    {
+    public:
+        AssetArchive() = default;
+        ~AssetArchive();
+
+        AssetArchive(const AssetArchive&) = delete;
+        AssetArchive& operator=(const AssetArchive&) = delete;
+
+        bool Open(const std::string& path);
+        void Close();
+
+        // Contents of the file at path (relative to the assets directory), or an empty span if it isn't in the archive
+        // Looking files up doesn't touch the disk, the pages are read in when the data is first used
+        std::span<const unsigned char> Find(std::string_view path) const;
+        std::size_t GetFileCount() const { return m_entries.size(); }
+        // Last write time of the archive file
+        int64_t GetModifiedTime() const { return m_modifiedTime; }
+
+    private:
+        const unsigned char* m_data = nullptr;
+        std::size_t m_size = 0;
+        std::span<const ArchiveEntry> m_entries;
+        int64_t m_modifiedTime = 0;
+
+#ifdef PLATFORM_WINDOWS
+        void* m_file = nullptr;
+        void* m_mapping = nullptr;
+#endif
+    };
+}
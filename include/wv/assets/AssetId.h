@@ -0,0 +1,29 @@
+#pragma once
+
+#include <wv/Hash.h>
+#include <wv/wvpch.h>
+#include <string_view>
+
+namespace WillowVox
+{
+    // Identifies an asset by the hash of its name, so lookups don't hash or copy strings
+    // Build it from a literal at compile time with "name"_asset or constexpr AssetId
+    // The name is only a view, so the string an id was built from must outlive the id
+    struct AssetId
+    {
+        constexpr AssetId(std::string_view name) : hash(Hash64(name)), name(name) {}
+        constexpr AssetId(const char* name) : AssetId(std::string_view(name)) {}
+        AssetId(const std::string& name) : AssetId(std::string_view(name)) {}
+
+        constexpr bool operator==(const AssetId& other) const { return hash == other.hash; }
+
+        uint64_t hash;
+        // Only used to load the asset on a cache miss
+        std::string_view name;
+    };
+
+    consteval AssetId operator""_asset(const char* name, std::size_t length)
+    {
+        return AssetId(std::string_view(name, length));
+    }
+}
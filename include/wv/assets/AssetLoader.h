@@ -1,15 +1,79 @@
 #pragma once
 
 #include <wv/wvpch.h>
+#include <concepts>
+#include <optional>
+#include <string_view>
 
 namespace WillowVox
 {
     // If you want to support loading a new asset type T,
     // you need to create a template specialization of this struct
+    //
+    // To load T asynchronously, the specialization can also split loading in two steps:
+    //   using Intermediate = ...;
+    //   // File I/O and decoding. Runs on a worker thread, so it must not touch GL
+    //   static Intermediate Decode(const std::string& name);
+    //   // Creates the GL objects from the decoded data. Runs on the main thread
+    //   static std::shared_ptr<T> Finalize(const std::string& name, Intermediate&& data);
+    // Loaders without these run Load on the main thread instead, except for GetAsset misses, which run it on the
+    // calling thread. Loaders that use GL in Load must split loading, so GetAsset can send Finalize to the main thread
+    //
+    // If the GL work itself can finish in the background (e.g. the driver compiling shaders), a split loader can
+    // also start it without waiting on it. Asynchronous loads use this instead of Finalize:
+    //   // Runs on the main thread. The future completes once the asset is ready
+    //   static Future<std::shared_ptr<T>> FinalizeAsync(const std::string& name, Intermediate&& data);
+    //
+    // To count T towards the asset memory budgets, the specialization can also report the size of an asset:
+    //   static std::size_t GetSize(const T& asset);
+    // Assets of types without it count as 0 bytes
+    //
+    // To hot-reload T when its files change, a split loader can also map a changed file to the name of its asset:
+    //   // e.g. "textures/grass.png" -> "grass". Returns nothing for files that don't belong to T
+    //   static std::optional<std::string> GetNameFromFile(std::string_view path);
+    // T must be move-assignable. The reloaded asset is moved into the existing one, so current handles see it
+    // Assets built from several files (e.g. shaders with includes) can also list the assets that read a changed file:
+    //   static std::vector<std::string> GetDependentsOfFile(std::string_view path);
     template<typename T>
     struct AssetLoader
     {
         // Load asset of type T from given name (e.g., file path)
         static std::shared_ptr<T> Load(const std::string& name);
     };
-}
\ No newline at end of file
+
+    // True if AssetLoader<T> splits loading into Decode and Finalize
+    template<typename T>
+    concept SplitAssetLoader = requires(const std::string& name, typename AssetLoader<T>::Intermediate& data)
+    {
+        { AssetLoader<T>::Decode(name) } -> std::same_as<typename AssetLoader<T>::Intermediate>;
+        { AssetLoader<T>::Finalize(name, std::move(data)) } -> std::same_as<std::shared_ptr<T>>;
+    };
+
+    // True if AssetLoader<T> can finish loading without blocking the main thread
+    template<typename T>
+    concept AsyncFinalizeAssetLoader = SplitAssetLoader<T> && requires(const std::string& name, typename AssetLoader<T>::Intermediate& data)
+    {
+        AssetLoader<T>::FinalizeAsync(name, std::move(data)).Get();
+    };
+
+    // True if AssetLoader<T> reports the memory used by an asset
+    template<typename T>
+    concept SizedAssetLoader = requires(const T& asset)
+    {
+        { AssetLoader<T>::GetSize(asset) } -> std::convertible_to<std::size_t>;
+    };
+
+    // True if assets of type T can be reloaded in place when their files change
+    template<typename T>
+    concept ReloadableAssetLoader = SplitAssetLoader<T> && std::is_move_assignable_v<T> && requires(std::string_view path)
+    {
+        { AssetLoader<T>::GetNameFromFile(path) } -> std::same_as<std::optional<std::string>>;
+    };
+
+    // True if AssetLoader<T> reloads assets when a file they depend on changes, not just their own files
+    template<typename T>
+    concept DependentAssetLoader = ReloadableAssetLoader<T> && requires(std::string_view path)
+    {
+        { AssetLoader<T>::GetDependentsOfFile(path) } -> std::same_as<std::vector<std::string>>;
+    };
+}
@@ -1,62 +1,141 @@
 #pragma once
 
+#include <wv/assets/AssetArchive.h>
 #include <wv/assets/AssetProvider.h>
+#include <wv/assets/AssetWatcher.h>
 #include <wv/wvpch.h>
 #include <typeindex>
 
 namespace WillowVox
 {
     // Manages loading and providing assets of various types
+    // Safe to use from any thread. GL work always runs on the main thread, see AssetProvider::GetAsset
     class AssetManager
     {
     public:
+        // The only instance. Providers are cached per type for the whole program, so there can't be others
         static AssetManager& GetInstance();
 
+        AssetManager(const AssetManager&) = delete;
+        AssetManager& operator=(const AssetManager&) = delete;
+
+        // Pool GetAssetAsync decodes assets on. Without one, GetAssetAsync loads synchronously
+        void SetThreadPool(ThreadPool* pool) { m_pool.store(pool, std::memory_order_release); }
+        ThreadPool* GetThreadPool() const { return m_pool.load(std::memory_order_acquire); }
+
+        // Map a packed archive built by AssetPacker, so asset files are read from it instead of the assets directory
+        // Call before loading any assets
+        bool MountArchive(const std::string& path);
+        // Read files that aren't in the mounted archive from the assets directory. On by default, for development
+        void SetLooseFiles(bool enabled) { m_looseFiles = enabled; }
+
+        // Reload assets in place when their files under the assets directory change (Linux only)
+        // Handles to the assets see the new versions. Files in a mounted archive shadow the loose files,
+        // so don't mount one while using this
+        bool EnableHotReload();
+        void DisableHotReload();
+
+        // Get the contents of an asset file by its path relative to the assets directory (e.g. "textures/grass.png")
+        // Files in the archive aren't copied. Safe on any thread
+        AssetFile OpenFile(std::string_view path);
+        // Size and modification time of the asset file OpenFile would return, without reading it
+        std::optional<AssetFileInfo> GetFileInfo(std::string_view path);
+
         // Get asset of type T by name
-        // Loads the asset if not already loaded
+        // Loads the asset if not already loaded. Off the main thread, a miss of a GL-backed type (e.g. Texture or Shader)
+        // waits for the main thread to create its GL objects, so call it from jobs the main thread doesn't wait on
+        // or use GetAssetAsync instead
         // Uses AssetLoader<T> to load the asset if needed. If you want to support loading a new asset type T,
         // you need to create a template specialization of AssetLoader
+        // id converts from any string, or use "name"_asset to hash the name at compile time
         template<typename T>
-        std::shared_ptr<T> GetAsset(const std::string& name)
+        std::shared_ptr<T> GetAsset(AssetId id)
         {
-            // Get the asset provider for the given type
-            AssetProvider<T>* provider = nullptr;
-            auto it = m_AssetTypes.find(typeid(T));
-            if (it != m_AssetTypes.end())
-                provider = static_cast<AssetProvider<T>*>(it->second.get());
-            else
-            {
-                // Create and register a new provider for this asset type
-                m_AssetTypes[typeid(T)] = std::make_unique<AssetProvider<T>>();
-                provider = static_cast<AssetProvider<T>*>(m_AssetTypes[typeid(T)].get());
-            }
+            return GetProvider<T>()->GetAsset(id);
+        }
 
-            // Get the asset from the provider
-            return provider->GetAsset(name);
+        // Get asset of type T by name without stalling the frame
+        // The returned future completes on the main thread once the asset is loaded (or immediately if it already is)
+        // File I/O and decoding run on the thread pool, only GL object creation runs on the main thread
+        template<typename T>
+        Future<std::shared_ptr<T>> GetAssetAsync(AssetId id)
+        {
+            return GetProvider<T>()->GetAssetAsync(id, m_pool.load(std::memory_order_acquire));
         }
 
         // Manually add asset of type T by name
         // This is usually not needed unless you want to pre-load assets or load runtime-generated assets
         template<typename T>
-        void AddAsset(const std::string& name, std::shared_ptr<T> asset)
+        void AddAsset(AssetId id, std::shared_ptr<T> asset)
+        {
+            GetProvider<T>()->AddAsset(id, asset);
+        }
+
+        // Name the asset of type T with this id was loaded from, for debugging and reloading
+        template<typename T>
+        std::string GetAssetName(AssetId id)
+        {
+            return GetProvider<T>()->GetName(id);
+        }
+
+        // Bytes all assets may use together, and the bytes assets of type T may use. 0 means no limit
+        // Going over a budget evicts the least recently used assets that nothing but the cache holds,
+        // so assets still in use are never freed and a budget can be exceeded while they are
+        // Sizes come from AssetLoader<T>::GetSize
+        void SetMemoryBudget(std::size_t bytes);
+        std::size_t GetMemoryBudget() const { return m_budget.load(std::memory_order_relaxed); }
+
+        template<typename T>
+        void SetMemoryBudget(std::size_t bytes)
         {
-            // Get the asset provider for the given type
-            AssetProvider<T>* provider = nullptr;
-            auto it = m_AssetTypes.find(typeid(T));
-            if (it != m_AssetTypes.end())
-                provider = static_cast<AssetProvider<T>*>(it->second.get());
-            else
-            {
-                // Create and register a new provider for this asset type
-                m_AssetTypes[typeid(T)] = std::make_unique<AssetProvider<T>>();
-                provider = static_cast<AssetProvider<T>*>(m_AssetTypes[typeid(T)].get());
-            }
+            GetProvider<T>()->SetBudget(bytes);
+        }
 
-            // Get the asset from the provider
-            provider->AddAsset(name, asset);
+        template<typename T>
+        std::size_t GetMemoryBudget()
+        {
+            return GetProvider<T>()->GetBudget();
+        }
+
+        // Cache hits, misses, evictions and resident bytes of all asset types together, or of type T
+        AssetCacheStats GetStats();
+
+        template<typename T>
+        AssetCacheStats GetStats()
+        {
+            return GetProvider<T>()->GetStats();
         }
 
     private:
+        AssetManager() = default;
+
+        // Get the asset provider for the given type
+        template<typename T>
+        AssetProvider<T>* GetProvider()
+        {
+            // Registered once per type on first use. Static init is thread-safe, so later lookups don't lock
+            // The static is shared by every caller, which is fine since GetInstance is the only instance
+            static AssetProvider<T>* provider = static_cast<AssetProvider<T>*>(RegisterProvider(typeid(T), std::make_unique<AssetProvider<T>>([this]() { EnforceBudget(); })));
+            return provider;
+        }
+
+        // Store the provider for a type, or return the one already stored
+        IAssetProvider* RegisterProvider(std::type_index type, std::unique_ptr<IAssetProvider> provider);
+        // Evict assets of every type until all of them fit in the global budget
+        void EnforceBudget();
+
+        std::mutex m_typesMutex;
         std::unordered_map<std::type_index, std::unique_ptr<IAssetProvider>> m_AssetTypes;
+        std::atomic<ThreadPool*> m_pool = nullptr;
+
+        AssetArchive m_archive;
+        bool m_looseFiles = true;
+
+        std::atomic<std::size_t> m_budget = 0;
+        // Type to evict from first next time, so one type doesn't take every eviction
+        std::size_t m_nextEvictType = 0;
+
+        // Declared last so it stops before anything its callback uses is destroyed
+        AssetWatcher m_watcher;
     };
-}
\ No newline at end of file
+}
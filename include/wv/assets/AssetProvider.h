@@ -1,43 +1,449 @@
 #pragma once
 
+#include <wv/Logger.h>
+#include <wv/assets/AssetId.h>
 #include <wv/assets/AssetLoader.h>
+#include <wv/threading/Future.h>
 #include <wv/wvpch.h>
+#include <algorithm>
+#include <shared_mutex>
 
 namespace WillowVox
 {
+    struct AssetCacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        // Sizes reported by AssetLoader<T>::GetSize of the assets in the cache
+        std::size_t residentBytes = 0;
+        std::size_t assetCount = 0;
+    };
+
     class IAssetProvider
     {
     public:
+        virtual ~IAssetProvider() = default;
+
+        // Evict assets nothing but the cache holds, in CLOCK order, until about bytes are freed
+        // Returns the number of bytes freed
+        virtual std::size_t Evict(std::size_t bytes) = 0;
+        virtual AssetCacheStats GetStats() const = 0;
+        // Reload the loaded asset the changed file (relative to the assets directory) belongs to, if any
+        // Runs on the main thread. Decoding runs on pool if there is one
+        virtual void ReloadFile(const std::string& path, ThreadPool* pool) = 0;
     };
 
     // Provides assets of type T, loading them on demand
+    // Safe to use from any thread, split loaders only ever run Finalize on the main thread
+    // Assets are spread over shards with their own locks,
+    // so lookups of different assets rarely touch the same lock and cache hits only take a shared lock
+    // Assets are keyed by AssetId, so a cache hit doesn't hash or allocate a string
     template<typename T>
     class AssetProvider : public IAssetProvider
     {
     public:
-        // Get asset of type T by name
+        // onGrow is called (without any locks held) after assets were added to the cache
+        AssetProvider(std::function<void()> onGrow = nullptr) : m_onGrow(std::move(onGrow)) {}
+
+        // Get asset of type T by id
         // Loads the asset if not already loaded
-        std::shared_ptr<T> GetAsset(const std::string& name)
+        // If two threads load the same asset at once, both get the one that was stored first
+        // Off the main thread, a miss of a split loader (see AssetLoader) decodes on the calling thread, then waits
+        // up to a frame for Finalize to run on the main thread. Don't call it from a job the main thread is waiting on,
+        // prefer GetAssetAsync there. Loaders without Finalize run Load on the calling thread, so they must not use GL
+        std::shared_ptr<T> GetAsset(AssetId id)
+        {
+            Shard& shard = GetShard(id.hash);
+            {
+                std::shared_lock lock(shard.mutex);
+                auto it = shard.assets.find(id.hash);
+                if (it != shard.assets.end())
+                    return Hit(shard, it->second);
+            }
+
+            // Load without holding the lock, so lookups in this shard don't wait on the load
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            std::string name(id.name);
+            std::shared_ptr<T> asset = LoadBlocking(name);
+
+            std::shared_ptr<T> stored;
+            {
+                std::unique_lock lock(shard.mutex);
+                stored = Store(shard, id.hash, std::move(name), asset);
+            }
+            OnGrow();
+            return stored;
+        }
+
+        // Get asset of type T by id without blocking on the load
+        // Decoding runs on pool and the GL work runs on the main thread, see AssetLoader
+        // Requests for an asset that is still loading share the same load
+        Future<std::shared_ptr<T>> GetAssetAsync(AssetId id, ThreadPool* pool)
         {
-            auto it = m_assets.find(name);
-            if (it != m_assets.end())
-                return it->second;
+            Shard& shard = GetShard(id.hash);
+            {
+                std::shared_lock lock(shard.mutex);
+                auto it = shard.assets.find(id.hash);
+                if (it != shard.assets.end())
+                    return MakeReadyFuture(Hit(shard, it->second));
+            }
+
+            // Nothing to load on, so load right away
+            if (!pool)
+                return MakeReadyFuture(GetAsset(id));
+
+            std::unique_lock lock(shard.mutex);
+
+            // Another thread may have loaded or started loading it in the meantime
+            auto it = shard.assets.find(id.hash);
+            if (it != shard.assets.end())
+                return MakeReadyFuture(Hit(shard, it->second));
+
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            auto pending = shard.pending.find(id.hash);
+            if (pending != shard.pending.end())
+                return pending->second;
+
+            // The load can't finish before it is added to pending, since FinishLoad needs this lock
+            uint64_t hash = id.hash;
+            Future<std::shared_ptr<T>> future;
+            if constexpr (AsyncFinalizeAssetLoader<T>)
+            {
+                // Finalizing only starts the GL work, the promise completes once the loader's future does
+                // Carries the pool, so Then continuations of the future run on it like they do for other loaders
+                Promise<std::shared_ptr<T>> promise(pool);
+                future = promise.GetFuture();
+                pool->Submit([name = std::string(id.name)]() {
+                    return AssetLoader<T>::Decode(name);
+                }, Priority::Low).ThenOnMainThread([this, hash, name = std::string(id.name), promise = std::move(promise)](typename AssetLoader<T>::Intermediate& data) mutable {
+                    AssetLoader<T>::FinalizeAsync(name, std::move(data)).ThenOnMainThread(
+                        [this, hash, name = std::move(name), promise = std::move(promise)](std::shared_ptr<T>& asset) mutable {
+                            promise.SetValue(FinishLoad(hash, std::move(name), asset));
+                        });
+                });
+            }
+            else if constexpr (SplitAssetLoader<T>)
+            {
+                // Low priority so streaming assets in doesn't hold up per-frame jobs
+                future = pool->Submit([name = std::string(id.name)]() {
+                    return AssetLoader<T>::Decode(name);
+                }, Priority::Low).ThenOnMainThread([this, hash, name = std::string(id.name)](typename AssetLoader<T>::Intermediate& data) mutable {
+                    std::shared_ptr<T> asset = AssetLoader<T>::Finalize(name, std::move(data));
+                    return FinishLoad(hash, std::move(name), asset);
+                });
+            }
             else
             {
-                std::shared_ptr<T> asset = AssetLoader<T>::Load(name);
-                m_assets.emplace(name, asset);
-                return asset;
+                // The loader might use GL, so the whole load runs on the main thread
+                future = MakeReadyFuture(std::string(id.name)).ThenOnMainThread([this, hash](std::string& name) {
+                    std::shared_ptr<T> asset = AssetLoader<T>::Load(name);
+                    return FinishLoad(hash, std::move(name), asset);
+                });
             }
+
+            shard.pending.emplace(id.hash, future);
+            return future;
         }
 
-        // Add asset of type T by name
+        // Add asset of type T by id
         // Used to manually add assets (e.g., pre-loaded or runtime-generated)
-        void AddAsset(const std::string& name, std::shared_ptr<T> asset)
+        void AddAsset(AssetId id, std::shared_ptr<T> asset)
         {
-            m_assets.emplace(name, asset);
+            Shard& shard = GetShard(id.hash);
+            {
+                std::unique_lock lock(shard.mutex);
+                Store(shard, id.hash, std::string(id.name), asset);
+            }
+            OnGrow();
+        }
+
+        // Name the asset with this id was loaded from, for debugging and reloading
+        // Empty if it isn't loaded
+        std::string GetName(AssetId id)
+        {
+            Shard& shard = GetShard(id.hash);
+            std::shared_lock lock(shard.mutex);
+            auto it = shard.assets.find(id.hash);
+            return it != shard.assets.end() ? it->second.name : std::string();
+        }
+
+        // Bytes assets of type T may use before the ones only the cache holds get evicted. 0 means no limit
+        void SetBudget(std::size_t bytes)
+        {
+            m_budget.store(bytes, std::memory_order_relaxed);
+            OnGrow();
+        }
+
+        std::size_t GetBudget() const { return m_budget.load(std::memory_order_relaxed); }
+
+        std::size_t Evict(std::size_t bytes) override
+        {
+            // One sweeper at a time, so the clock hands move consistently
+            std::lock_guard<std::mutex> evictLock(m_evictMutex);
+
+            // Every shard is swept twice, so assets referenced since the last sweep get their second chance
+            std::size_t freed = 0;
+            std::vector<std::shared_ptr<T>> evicted;
+            for (std::size_t i = 0; i < NUM_SHARDS * 2 && freed < bytes; i++)
+            {
+                Shard& shard = m_shards[m_clockShard];
+                m_clockShard = (m_clockShard + 1) % NUM_SHARDS;
+
+                std::unique_lock lock(shard.mutex);
+                freed += Sweep(shard, bytes - freed, evicted);
+            }
+
+            // Destroy the assets after unlocking, so lookups don't wait on it
+            evicted.clear();
+            return freed;
+        }
+
+        AssetCacheStats GetStats() const override
+        {
+            AssetCacheStats stats;
+            for (const Shard& shard : m_shards)
+            {
+                stats.hits += shard.hits.load(std::memory_order_relaxed);
+                stats.misses += shard.misses.load(std::memory_order_relaxed);
+                stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+                stats.assetCount += shard.count.load(std::memory_order_relaxed);
+            }
+            stats.residentBytes = m_residentBytes.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        void ReloadFile(const std::string& path, ThreadPool* pool) override
+        {
+            if constexpr (ReloadableAssetLoader<T>)
+            {
+                std::vector<std::string> names;
+                if (std::optional<std::string> name = AssetLoader<T>::GetNameFromFile(path))
+                    names.push_back(std::move(*name));
+
+                if constexpr (DependentAssetLoader<T>)
+                {
+                    for (std::string& dependent : AssetLoader<T>::GetDependentsOfFile(path))
+                    {
+                        if (std::find(names.begin(), names.end(), dependent) == names.end())
+                            names.push_back(std::move(dependent));
+                    }
+                }
+
+                for (const std::string& name : names)
+                    ReloadAsset(name, pool);
+            }
         }
 
     private:
-        std::unordered_map<std::string, std::shared_ptr<T>> m_assets;
+        static constexpr std::size_t NUM_SHARDS = 16;
+
+        struct Entry
+        {
+            std::shared_ptr<T> asset;
+            std::string name;
+            std::size_t size = 0;
+            // Set on every hit, cleared by the clock hand passing over it
+            std::atomic<bool> referenced = false;
+        };
+
+        // Padded to a cache line so threads using neighbouring shards don't contend
+        struct alignas(64) Shard
+        {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<uint64_t, Entry> assets;
+            // Loads started by GetAssetAsync that haven't finished yet
+            std::unordered_map<uint64_t, Future<std::shared_ptr<T>>> pending;
+            // Id of the entry the clock hand points at
+            uint64_t hand = 0;
+
+            // Kept per shard, so counting hits doesn't add a cache line every thread writes to
+            std::atomic<uint64_t> hits = 0;
+            std::atomic<uint64_t> misses = 0;
+            std::atomic<uint64_t> evictions = 0;
+            std::atomic<std::size_t> count = 0;
+        };
+
+        Shard& GetShard(uint64_t hash)
+        {
+            // The maps hash with the low bits, so pick the shard with the high bits
+            return m_shards[(hash >> 32) % NUM_SHARDS];
+        }
+
+        // The shard's lock must be held, shared is enough
+        std::shared_ptr<T> Hit(Shard& shard, Entry& entry)
+        {
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            // Only write when it changes, so hot assets don't bounce the cache line between threads
+            if (!entry.referenced.load(std::memory_order_relaxed))
+                entry.referenced.store(true, std::memory_order_relaxed);
+            return entry.asset;
+        }
+
+        // Store an asset unless one is already stored for the id, and return the stored one
+        // The shard's lock must be held exclusively
+        std::shared_ptr<T> Store(Shard& shard, uint64_t hash, std::string name, std::shared_ptr<T> asset)
+        {
+            auto it = shard.assets.find(hash);
+            if (it != shard.assets.end())
+            {
+                if (it->second.name != name)
+                    Logger::EngineError("Asset names %s and %s have the same id", it->second.name.c_str(), name.c_str());
+                return it->second.asset;
+            }
+
+            Entry& entry = shard.assets[hash];
+            entry.asset = asset;
+            entry.name = std::move(name);
+            entry.referenced.store(true, std::memory_order_relaxed);
+            if constexpr (SizedAssetLoader<T>)
+            {
+                if (asset)
+                    entry.size = AssetLoader<T>::GetSize(*asset);
+            }
+
+            m_residentBytes.fetch_add(entry.size, std::memory_order_relaxed);
+            shard.count.fetch_add(1, std::memory_order_relaxed);
+            return asset;
+        }
+
+        // Move the shard's clock hand over its entries once, evicting unreferenced assets nothing else holds
+        // The shard's lock must be held exclusively
+        std::size_t Sweep(Shard& shard, std::size_t bytes, std::vector<std::shared_ptr<T>>& evicted)
+        {
+            std::size_t freed = 0;
+            std::size_t remaining = shard.assets.size();
+            auto it = shard.assets.find(shard.hand);
+            if (it == shard.assets.end())
+                it = shard.assets.begin();
+
+            while (remaining > 0 && freed < bytes)
+            {
+                if (it == shard.assets.end())
+                    it = shard.assets.begin();
+                remaining--;
+
+                Entry& entry = it->second;
+                if (entry.referenced.load(std::memory_order_relaxed))
+                {
+                    entry.referenced.store(false, std::memory_order_relaxed);
+                    ++it;
+                }
+                else if (entry.asset.use_count() <= 1)
+                {
+                    freed += entry.size;
+                    m_residentBytes.fetch_sub(entry.size, std::memory_order_relaxed);
+                    shard.evictions.fetch_add(1, std::memory_order_relaxed);
+                    shard.count.fetch_sub(1, std::memory_order_relaxed);
+                    evicted.push_back(std::move(entry.asset));
+                    it = shard.assets.erase(it);
+                }
+                else
+                    ++it;
+            }
+
+            shard.hand = it != shard.assets.end() ? it->first : 0;
+            return freed;
+        }
+
+        // Load an asset on the calling thread
+        // Split loaders create their GL objects in Finalize, so off the main thread it is sent there and waited on
+        std::shared_ptr<T> LoadBlocking(const std::string& name)
+        {
+            if constexpr (SplitAssetLoader<T>)
+            {
+                if (!MainThreadQueue::IsMainThread())
+                {
+                    return MakeReadyFuture(AssetLoader<T>::Decode(name)).ThenOnMainThread([name](typename AssetLoader<T>::Intermediate& data) {
+                        return AssetLoader<T>::Finalize(name, std::move(data));
+                    }).Get();
+                }
+            }
+
+            return AssetLoader<T>::Load(name);
+        }
+
+        // Store an asynchronously loaded asset. Runs on the main thread
+        std::shared_ptr<T> FinishLoad(uint64_t hash, std::string name, std::shared_ptr<T> asset)
+        {
+            Shard& shard = GetShard(hash);
+            std::shared_ptr<T> stored;
+            {
+                std::unique_lock lock(shard.mutex);
+                shard.pending.erase(hash);
+                stored = Store(shard, hash, std::move(name), asset);
+            }
+            OnGrow();
+            return stored;
+        }
+
+        // Enforce this type's budget, then let the owner enforce the global one
+        void OnGrow()
+        {
+            std::size_t budget = m_budget.load(std::memory_order_relaxed);
+            std::size_t resident = m_residentBytes.load(std::memory_order_relaxed);
+            if (budget > 0 && resident > budget)
+                Evict(resident - budget);
+
+            if (m_onGrow)
+                m_onGrow();
+        }
+
+        // Decode name again and move it into the loaded asset
+        // Assets that aren't loaded pick up the new file when they are
+        void ReloadAsset(const std::string& name, ThreadPool* pool) requires ReloadableAssetLoader<T>
+        {
+            uint64_t hash = AssetId(name).hash;
+            std::shared_ptr<T> asset;
+            {
+                Shard& shard = GetShard(hash);
+                std::shared_lock lock(shard.mutex);
+                auto it = shard.assets.find(hash);
+                if (it != shard.assets.end())
+                    asset = it->second.asset;
+            }
+            if (!asset)
+                return;
+
+            Future<typename AssetLoader<T>::Intermediate> decoded = pool
+                ? pool->Submit([name]() { return AssetLoader<T>::Decode(name); })
+                : MakeReadyFuture(AssetLoader<T>::Decode(name));
+
+            decoded.ThenOnMainThread([this, hash, name, asset](typename AssetLoader<T>::Intermediate& data) {
+                std::shared_ptr<T> reloaded = AssetLoader<T>::Finalize(name, std::move(data));
+                if (!reloaded)
+                {
+                    Logger::EngineError("Failed to reload %s, keeping the old version", name.c_str());
+                    return;
+                }
+
+                // Swap the new GPU objects into the asset everyone already holds
+                *asset = std::move(*reloaded);
+                Logger::EngineLog("Reloaded %s", name.c_str());
+
+                if constexpr (SizedAssetLoader<T>)
+                {
+                    Shard& shard = GetShard(hash);
+                    std::unique_lock lock(shard.mutex);
+                    auto it = shard.assets.find(hash);
+                    if (it != shard.assets.end() && it->second.asset == asset)
+                    {
+                        std::size_t size = AssetLoader<T>::GetSize(*asset);
+                        m_residentBytes.fetch_add(size, std::memory_order_relaxed);
+                        m_residentBytes.fetch_sub(it->second.size, std::memory_order_relaxed);
+                        it->second.size = size;
+                    }
+                }
+            });
+        }
+
+        std::array<Shard, NUM_SHARDS> m_shards;
+
+        std::atomic<std::size_t> m_residentBytes = 0;
+        std::atomic<std::size_t> m_budget = 0;
+        std::function<void()> m_onGrow;
+
+        std::mutex m_evictMutex;
+        std::size_t m_clockShard = 0;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <wv/wvpch.h>
+#include <atomic>
+
+namespace WillowVox
+{
+    // Watches a directory tree for files that are written or replaced
+    // Uses inotify, so it is only supported on Linux. The watcher thread sleeps until something changes
+    class AssetWatcher
+    {
+    public:
+        // Called on the watcher thread with the changed file's path relative to the root, with '/' separators
+        using Callback = std::function<void(const std::string&)>;
+
+        AssetWatcher() = default;
+        ~AssetWatcher();
+
+        AssetWatcher(const AssetWatcher&) = delete;
+        AssetWatcher& operator=(const AssetWatcher&) = delete;
+
+        bool Start(const std::string& root, Callback onChange);
+        void Stop();
+        bool IsRunning() const { return m_thread.joinable(); }
+
+    private:
+        void ThreadLoop();
+        void AddWatches(const std::string& directory);
+
+        std::string m_root;
+        Callback m_onChange;
+        std::thread m_thread;
+
+        int m_inotify = -1;
+        // Written to by Stop to wake the watcher thread
+        int m_stopEvent = -1;
+        // Watch descriptor to directory, relative to the root
+        std::unordered_map<int, std::string> m_directories;
+    };
+}
@@ -2,11 +2,15 @@
 
 #include <wv/wvpch.h>
 
+#include <wv/Hash.h>
 #include <wv/Logger.h>
 
 #include <wv/app/App.h>
 
+#include <wv/assets/AssetArchive.h>
+#include <wv/assets/AssetId.h>
 #include <wv/assets/AssetManager.h>
+#include <wv/assets/AssetWatcher.h>
 
 #include <wv/events/Event.h>
 #include <wv/events/EventDispatcher.h>
@@ -14,11 +18,25 @@
 #include <wv/input/Input.h>
 
 #include <wv/rendering/Camera.h>
+#include <wv/rendering/GLDeletionQueue.h>
+#include <wv/rendering/Image.h>
 #include <wv/rendering/Renderer.h>
 #include <wv/rendering/Window.h>
 #include <wv/rendering/Shader.h>
+#include <wv/rendering/ShaderCache.h>
+#include <wv/rendering/ShaderCompiler.h>
 #include <wv/rendering/Texture.h>
+#include <wv/rendering/TextureArray.h>
+#include <wv/rendering/TextureCache.h>
+#include <wv/rendering/TextureStreamer.h>
+#include <wv/rendering/UniformBuffer.h>
 #include <wv/rendering/VertexArrayObject.h>
 #include <wv/rendering/Window.h>
 
+#include <wv/threading/CpuTopology.h>
+#include <wv/threading/Future.h>
+#include <wv/threading/Job.h>
+#include <wv/threading/MainThreadQueue.h>
+#include <wv/threading/Parallel.h>
+#include <wv/threading/TaskGraph.h>
 #include <wv/threading/ThreadPool.h>
\ No newline at end of file
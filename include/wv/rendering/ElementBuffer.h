@@ -16,7 +16,7 @@ namespace WillowVox
     public:
         ElementBuffer();
         ElementBuffer(ElementBuffer&& other) noexcept;
-        // Make sure destructor only runs on the main thread
+        // Safe on any thread, the GL object is deleted through GLDeletionQueue
         ~ElementBuffer();
 
         void Bind();
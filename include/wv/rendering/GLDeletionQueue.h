@@ -0,0 +1,28 @@
+#pragma once
+
+#include <concurrentqueue.h>
+#include <wv/wvpch.h>
+
+namespace WillowVox
+{
+    // Deletes GL objects from any thread
+    // On the main thread objects are deleted right away. On other threads the handles are queued
+    // and deleted in batches the next time the main thread calls Flush
+    class GLDeletionQueue
+    {
+    public:
+        static void DeleteBuffer(unsigned int id);
+        static void DeleteVertexArray(unsigned int id);
+        static void DeleteTexture(unsigned int id);
+        static void DeleteProgram(unsigned int id);
+
+        // Delete everything queued so far. Must be called on the main thread
+        static void Flush();
+
+    private:
+        static moodycamel::ConcurrentQueue<unsigned int> m_buffers;
+        static moodycamel::ConcurrentQueue<unsigned int> m_vertexArrays;
+        static moodycamel::ConcurrentQueue<unsigned int> m_textures;
+        static moodycamel::ConcurrentQueue<unsigned int> m_programs;
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <wv/wvpch.h>
+#include <span>
+
+namespace WillowVox
+{
+    struct ImageDecodeOptions
+    {
+        // Channels per pixel in the result, 1 to 4. 0 keeps the file's own channel count
+        int channels = 0;
+        // Put the bottom row first, as GL expects
+        bool flipVertically = true;
+        // Where to write the pixels, e.g. a mapped upload buffer or an arena
+        // If empty, the image allocates and owns its pixels
+        std::span<unsigned char> destination;
+        // Bytes between the starts of rows in destination. 0 for tightly packed rows
+        std::size_t stride = 0;
+    };
+
+    // Pixels decoded from an image file
+    // Either owns its pixels or views the destination they were decoded into. Doesn't use GL, so it is safe on any thread
+    class Image
+    {
+    public:
+        // Decode an image file that is already in memory
+        // Returns an empty image if the file can't be decoded or doesn't fit the destination
+        static Image Decode(std::span<const unsigned char> file, const ImageDecodeOptions& options = {});
+        static Image Load(const std::string& path, const ImageDecodeOptions& options = {});
+        // Read the size and channel count from the file header without decoding the pixels,
+        // e.g. to allocate a destination first
+        static bool GetInfo(std::span<const unsigned char> file, int& width, int& height, int& channels);
+
+        Image() = default;
+        ~Image();
+
+        Image(Image&& other) noexcept;
+        Image& operator=(Image&& other) noexcept;
+
+        explicit operator bool() const { return m_pixels != nullptr; }
+
+        unsigned char* GetPixels() { return m_pixels; }
+        const unsigned char* GetPixels() const { return m_pixels; }
+        int GetWidth() const { return m_width; }
+        int GetHeight() const { return m_height; }
+        int GetChannels() const { return m_channels; }
+        // Bytes between the starts of rows
+        std::size_t GetStride() const { return m_stride; }
+        // Bytes from the start of the first row to the end of the last
+        std::size_t GetSize() const;
+        // True if the pixels were written into a caller's destination
+        bool IsExternal() const { return m_pixels && !m_owned; }
+
+    private:
+        unsigned char* m_pixels = nullptr;
+        int m_width = 0;
+        int m_height = 0;
+        int m_channels = 0;
+        std::size_t m_stride = 0;
+        // Owned pixels come from stb_image and are freed with it
+        bool m_owned = false;
+    };
+}
@@ -1,7 +1,39 @@
 #pragma once
 
+#include <wv/rendering/UniformBuffer.h>
+#include <wv/wvpch.h>
+
 namespace WillowVox
 {
+    class Camera;
+
+    // Per-frame values shared by every shader through one uniform buffer. Declare it in GLSL as:
+    // layout(std140, binding = 0) uniform FrameConstants
+    // {
+    //     mat4 view;
+    //     mat4 projection;
+    //     mat4 viewProjection;
+    //     vec3 cameraPosition;
+    //     float time;
+    //     float deltaTime;
+    // };
+    struct FrameConstants
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;
+        glm::vec3 cameraPosition;
+        float time;
+        float deltaTime;
+    };
+
+    static_assert(offsetof(FrameConstants, view) == 0);
+    WV_STD140_MEMBER(FrameConstants, projection, view);
+    WV_STD140_MEMBER(FrameConstants, viewProjection, projection);
+    WV_STD140_MEMBER(FrameConstants, cameraPosition, viewProjection);
+    WV_STD140_MEMBER(FrameConstants, time, cameraPosition);
+    WV_STD140_MEMBER(FrameConstants, deltaTime, time);
+
     class Renderer
     {
     public:
@@ -14,7 +46,20 @@ namespace WillowVox
         static void SetVsync(bool enabled);
         static bool VysncEnabled() { return m_vsyncEnabled; }
 
+        // Uniform block binding point of FrameConstants
+        static constexpr unsigned int FRAME_CONSTANTS_BINDING = 0;
+
+        // Camera the frame constants are taken from. Must outlive its use, or be reset to nullptr
+        static void SetCamera(Camera* camera) { m_camera = camera; }
+        static Camera* GetCamera() { return m_camera; }
+        // Upload the frame constants once for every shader. Called by App before Render
+        static void UpdateFrameConstants(float time, float deltaTime);
+        static const FrameConstants& GetFrameConstants() { return m_frameConstants; }
+
     private:
         static bool m_vsyncEnabled;
+        static Camera* m_camera;
+        static FrameConstants m_frameConstants;
+        static std::unique_ptr<UniformBuffer> m_frameBuffer;
     };
-}
\ No newline at end of file
+}
@@ -1,23 +1,64 @@
 #pragma once
 
 #include <wv/assets/AssetLoader.h>
+#include <wv/threading/Future.h>
 #include <wv/wvpch.h>
 
 namespace WillowVox
 {
+    // Vertex and fragment source code of a shader
+    struct ShaderSource
+    {
+        std::string vertex;
+        std::string fragment;
+    };
+
+    // Uniform resolved once with Shader::GetUniform, to skip the name lookup on every set
+    // Handles survive the shader being reloaded, they are looked up again by name hash if the program changed
+    struct UniformHandle
+    {
+        uint64_t hash = 0;
+        // Uniform table the index below belongs to
+        uint32_t generation = 0;
+        int index = -1;
+    };
+
+    // Uniform uploads across every shader since the last reset
+    struct UniformStats
+    {
+        uint64_t issued = 0;
+        // Sets skipped because the uniform already had that value
+        uint64_t skipped = 0;
+    };
+
     class Shader
     {
     public:
         static std::shared_ptr<Shader> FromFiles(const char* vertexShaderPath, const char* fragmentShaderPath);
         static std::shared_ptr<Shader> FromFiles(const std::string& name);
         static std::shared_ptr<Shader> FromSource(const char* vertexShaderCode, const char* fragmentShaderCode);
+        // Read the source files for name, from the mounted archive or assets/shaders
+        // #include "file" lines are replaced with the file, relative to the shaders folder
+        // Doesn't use GL, so it is safe on any thread
+        static ShaderSource ReadFiles(const std::string& name);
+        // Names of the shaders whose last ReadFiles included the file at path, e.g. "shaders/common.glsl"
+        static std::vector<std::string> GetShadersIncluding(std::string_view path);
 
-        Shader(unsigned int programId) : _programId(programId) {}
-        // Make sure destructor only runs on the main thread
+        // Reflects the active uniforms of the linked program, so setting them never asks the driver for a location
+        Shader(unsigned int programId);
+        // Safe on any thread, the GL object is deleted through GLDeletionQueue
         ~Shader();
 
+        // Moving takes over the GL program, e.g. to swap a reloaded shader into an existing one
+        Shader(Shader&& other) noexcept;
+        Shader& operator=(Shader&& other) noexcept;
+
         void Bind();
 
+        // Uniforms are set with glProgramUniform*, so the shader doesn't need to be bound
+        // Each value is shadowed on the CPU and only uploaded when it changes. Setting uniforms of the
+        // program with raw GL calls leaves the shadow stale
+
         void SetBool(const char* name, bool value) const;
         void SetInt(const char* name, int value) const;
         void SetFloat(const char* name, float value) const;
@@ -29,15 +70,113 @@ namespace WillowVox
         void SetVec4(const char* name, float x, float y, float z, float w) const;
         void SetMat4(const char* name, glm::mat4 value) const;
 
+        // Look a uniform up once and reuse the handle. Array elements are named like "lights[2]"
+        UniformHandle GetUniform(const char* name) const;
+        bool HasUniform(const char* name) const;
+
+        void SetBool(UniformHandle uniform, bool value) const;
+        void SetInt(UniformHandle uniform, int value) const;
+        void SetFloat(UniformHandle uniform, float value) const;
+        void SetVec2(UniformHandle uniform, glm::vec2 value) const;
+        void SetVec3(UniformHandle uniform, glm::vec3 value) const;
+        void SetVec4(UniformHandle uniform, glm::vec4 value) const;
+        void SetMat4(UniformHandle uniform, glm::mat4 value) const;
+
+        static UniformStats GetUniformStats() { return m_stats; }
+        static void ResetUniformStats() { m_stats = {}; }
+
     private:
+        struct Uniform
+        {
+            uint64_t hash;
+            int location;
+            unsigned int type;
+            // Shadow value slot, shared by names with the same location (e.g. "lights" and "lights[0]")
+            int slot;
+        };
+
+        struct ValueSlot
+        {
+            uint32_t offset;
+            uint32_t size;
+            bool set;
+        };
+
+        // Read one source file into output, expanding its includes. included lists the files already included
+        static bool ReadSource(const std::string& path, std::string& output, std::vector<std::string>& included);
+        // Link a program from source, or load it from ShaderCache. Names identify the sources in errors
+        static unsigned int CompileProgram(const char* vertexShaderCode, const char* fragmentShaderCode, const char* vertexName, const char* fragmentName);
+
+        void ReflectUniforms();
+        int AddSlot(unsigned int type);
+        // Index into m_uniforms, or -1
+        int FindUniform(uint64_t hash) const;
+        int GetIndex(const char* name) const;
+        int GetIndex(UniformHandle uniform) const;
+        void WarnMissing(const char* name) const;
+        // Compare value with the shadow of the uniform at index and update it
+        // False if the upload can be skipped
+        bool UpdateShadow(int index, const void* value, std::size_t size) const;
+
+        void SetIntAt(int index, int value) const;
+        void SetFloatAt(int index, float value) const;
+        void SetVec2At(int index, glm::vec2 value) const;
+        void SetVec3At(int index, glm::vec3 value) const;
+        void SetVec4At(int index, glm::vec4 value) const;
+        void SetMat4At(int index, const glm::mat4& value) const;
+
         unsigned int _programId;
+        // Active uniforms sorted by name hash
+        std::vector<Uniform> m_uniforms;
+        uint32_t m_generation = 0;
+        mutable std::vector<ValueSlot> m_slots;
+        mutable std::vector<unsigned char> m_values;
+        // Names already warned about, so each is only reported once
+        mutable std::vector<uint64_t> m_missing;
+
+        // Uniforms are only set on the main thread
+        static UniformStats m_stats;
+        // Files included by each shader, by name. ReadFiles runs on worker threads, so it is locked
+        static std::mutex m_includesMutex;
+        static std::unordered_map<std::string, std::vector<std::string>> m_includes;
     };
 
     template<> struct AssetLoader<Shader>
     {
+        using Intermediate = ShaderSource;
+
         static std::shared_ptr<Shader> Load(const std::string& name)
         {
             return Shader::FromFiles(name);
         }
+
+        static ShaderSource Decode(const std::string& name)
+        {
+            return Shader::ReadFiles(name);
+        }
+
+        static std::shared_ptr<Shader> Finalize(const std::string& name, ShaderSource&& source)
+        {
+            if (source.vertex.empty() || source.fragment.empty())
+                return nullptr;
+            return Shader::FromSource(source.vertex.c_str(), source.fragment.c_str());
+        }
+
+        // Submits the compile and completes once the driver is done, see ShaderCompiler
+        static Future<std::shared_ptr<Shader>> FinalizeAsync(const std::string& name, ShaderSource&& source);
+
+        static std::optional<std::string> GetNameFromFile(std::string_view path)
+        {
+            if (!path.starts_with("shaders/") || !(path.ends_with(".vert") || path.ends_with(".frag")))
+                return std::nullopt;
+
+            return std::string(path.substr(8, path.size() - 8 - 5));
+        }
+
+        // Shaders that include the changed file, so editing e.g. shaders/common.glsl reloads them
+        static std::vector<std::string> GetDependentsOfFile(std::string_view path)
+        {
+            return Shader::GetShadersIncluding(path);
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <wv/wvpch.h>
+#include <string_view>
+
+namespace WillowVox
+{
+    // On-disk cache of linked program binaries, so shaders are only compiled again after their source changes
+    // Entries are named by the hash of the source text and the GL vendor, renderer and version, since
+    // binaries are only valid for the driver that made them
+    class ShaderCache
+    {
+    public:
+        // Directory to keep the cache in (e.g. "cache/shaders"). Empty turns the cache off, which is the default
+        static void SetDirectory(const std::string& directory) { m_directory = directory; }
+        static const std::string& GetDirectory() { return m_directory; }
+        // Also false if the driver doesn't support any program binary formats. Must be called on the main thread
+        static bool IsEnabled();
+
+        // Create a program from the cached binary for these sources. Must be called on the main thread
+        // Returns 0 if there is no entry or the driver rejects it, in which case the program has to be compiled
+        static unsigned int Load(std::string_view vertexSource, std::string_view fragmentSource);
+        // Cache the binary of a program linked from these sources. Must be called on the main thread
+        // Set GL_PROGRAM_BINARY_RETRIEVABLE_HINT on the program before linking it
+        static void Store(unsigned int program, std::string_view vertexSource, std::string_view fragmentSource);
+
+    private:
+        static uint64_t GetKey(std::string_view vertexSource, std::string_view fragmentSource);
+        static std::string GetCachePath(uint64_t key);
+
+        static std::string m_directory;
+    };
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <wv/rendering/Shader.h>
+#include <wv/threading/Future.h>
+#include <wv/wvpch.h>
+#include <span>
+
+namespace WillowVox
+{
+    // Compiles shader programs without making the main thread wait on the driver
+    // Every compile and link is submitted up front. With KHR_parallel_shader_compile the driver works on them on its
+    // own threads and they are polled once a frame, otherwise they are all finished on the next frame
+    // Loading shaders with AssetManager::GetAssetAsync goes through here, with the file reads on worker threads
+    class ShaderCompiler
+    {
+    public:
+        // GL objects of a program that has been submitted to the driver
+        struct Program
+        {
+            unsigned int vertex = 0;
+            unsigned int fragment = 0;
+            unsigned int program = 0;
+            ShaderSource source;
+            // Identify the sources in errors
+            std::string vertexName;
+            std::string fragmentName;
+        };
+
+        // Start compiling one program. Must be called on the main thread
+        // The future completes on the main thread, holding nullptr if the program failed to compile or link
+        static Future<std::shared_ptr<Shader>> Compile(ShaderSource source, const std::string& name = "");
+        // Start compiling every program before waiting on any of them. Must be called on the main thread
+        static std::vector<Future<std::shared_ptr<Shader>>> CompileBatch(std::span<const ShaderSource> sources);
+
+        // True if the driver compiles programs in the background
+        static bool IsParallel();
+
+        // Create the shaders and program and start compiling and linking them, without checking the results
+        static Program Submit(ShaderSource source, std::string vertexName, std::string fragmentName);
+        // Check the results of a submitted program, blocking until the driver is done with it
+        // Logs any errors and caches the binary if it linked. The program is kept either way
+        static bool Finish(Program& program);
+
+    private:
+        struct PendingProgram
+        {
+            Program program;
+            Promise<std::shared_ptr<Shader>> promise;
+        };
+
+        // True once the driver has finished compiling and linking the program
+        static bool IsComplete(const Program& program);
+        // Finish the programs the driver is done with. Posts itself again while any are left
+        static void Poll();
+
+        static std::vector<PendingProgram> m_pending;
+        static bool m_polling;
+    };
+}
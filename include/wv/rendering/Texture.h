@@ -5,17 +5,42 @@
 
 namespace WillowVox
 {
+    // Decoded RGBA pixels, ready to upload
+    struct TextureData
+    {
+        // Every mip level back to back, largest first
+        std::vector<unsigned char> pixels;
+        int width = 0;
+        int height = 0;
+        // 1 if only the base level is there, the GPU generates the rest on upload
+        int mipLevels = 1;
+    };
+
     class Texture
     {
     public:
         static std::shared_ptr<Texture> FromName(const std::string& name);
+        // Read and decode the texture file for name, from the mounted archive or assets/textures
+        // Doesn't use GL, so it is safe on any thread
+        // Decoded textures are cached if TextureCache is enabled
+        static TextureData Decode(const std::string& name);
+        // Build the mip chain of a texture with only its base level on the CPU
+        static void GenerateMipmaps(TextureData& texture);
         static std::shared_ptr<Texture> FromData(const std::vector<unsigned char>& data, int width, int height);
+        static std::shared_ptr<Texture> FromData(const TextureData& data);
         static std::vector<unsigned char> GetTextureData(const std::string& path, int& width, int& height);
 
         Texture(const char* path);
         Texture(const std::vector<unsigned char>& data, int width, int height);
+        Texture(const TextureData& data);
+        // Empty texture, e.g. to fill in later with SetSubData or TextureStreamer
+        Texture(int width, int height);
         ~Texture();
 
+        // Moving takes over the GL texture, e.g. to swap a reloaded texture into an existing one
+        Texture(Texture&& other) noexcept;
+        Texture& operator=(Texture&& other) noexcept;
+
         enum TexSlot
         {
             TEX00,
@@ -39,6 +64,10 @@ namespace WillowVox
 
         void BindTexture(TexSlot slot);
 
+        // Replace part of the base level with tightly packed RGBA rows. Must be called on the main thread
+        // Textures are sampled without mipmaps, so the other levels are left alone
+        void SetSubData(int x, int y, int width, int height, const unsigned char* pixels);
+
         int m_width, m_height;
 
     private:
@@ -47,9 +76,39 @@ namespace WillowVox
 
     template<> struct AssetLoader<Texture>
     {
+        using Intermediate = TextureData;
+
         static std::shared_ptr<Texture> Load(const std::string& name)
         {
             return Texture::FromName(name);
         }
+
+        static TextureData Decode(const std::string& name)
+        {
+            return Texture::Decode(name);
+        }
+
+        static std::shared_ptr<Texture> Finalize(const std::string& name, TextureData&& data)
+        {
+            if (data.pixels.empty())
+                return nullptr;
+            return Texture::FromData(data);
+        }
+
+        static std::optional<std::string> GetNameFromFile(std::string_view path)
+        {
+            if (!path.starts_with("textures/"))
+                return std::nullopt;
+
+            path.remove_prefix(9);
+            std::size_t extension = path.rfind('.');
+            return std::string(path.substr(0, extension));
+        }
+
+        // RGBA8 texels plus a third for the mipmaps
+        static std::size_t GetSize(const Texture& texture)
+        {
+            return static_cast<std::size_t>(texture.m_width) * texture.m_height * 4 * 4 / 3;
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <wv/assets/AssetId.h>
+#include <wv/assets/AssetLoader.h>
+#include <wv/rendering/Texture.h>
+#include <wv/wvpch.h>
+
+namespace WillowVox
+{
+    class ThreadPool;
+
+    // Decoded RGBA layers of a texture array, back to back
+    struct TextureArrayData
+    {
+        std::vector<unsigned char> pixels;
+        int width = 0;
+        int height = 0;
+        // Texture name of each layer
+        std::vector<std::string> layers;
+    };
+
+    // Many same-size textures in one GL_TEXTURE_2D_ARRAY, so e.g. all block textures of a chunk need one binding
+    // Shaders sample it with a sampler2DArray and the layer index from GetLayer
+    class TextureArray
+    {
+    public:
+        // Decode the named textures into one block of layers, in parallel on pool if there is one
+        // Every texture must be the size of the first, textures that fail to load leave their layer blank
+        // Doesn't use GL, so it is safe on any thread
+        static TextureArrayData Decode(const std::vector<std::string>& names, ThreadPool* pool);
+        // Texture names listed in assets/texture_arrays/<name>.txt, one per line. Lines starting with # are skipped
+        static std::vector<std::string> ReadManifest(const std::string& name);
+        static std::shared_ptr<TextureArray> FromNames(const std::vector<std::string>& names, ThreadPool* pool = nullptr);
+
+        // Uploads every layer with one call, then generates the mipmaps
+        TextureArray(const TextureArrayData& data);
+        ~TextureArray();
+
+        // Moving takes over the GL texture, so the old one is deleted exactly once
+        TextureArray(TextureArray&& other) noexcept;
+        TextureArray& operator=(TextureArray&& other) noexcept;
+
+        void BindTexture(Texture::TexSlot slot);
+
+        // Layer of the texture with this name, or -1 if it isn't in the array
+        int GetLayer(AssetId id) const;
+        int GetLayerCount() const { return m_layerCount; }
+
+        int m_width, m_height;
+
+    private:
+        unsigned int m_textureId;
+        int m_layerCount;
+        // Texture name hash to layer
+        std::unordered_map<uint64_t, int> m_layers;
+    };
+
+    // Loads the texture array listed in assets/texture_arrays/<name>.txt
+    // Layers are decoded in parallel on the AssetManager's thread pool
+    template<> struct AssetLoader<TextureArray>
+    {
+        using Intermediate = TextureArrayData;
+
+        static std::shared_ptr<TextureArray> Load(const std::string& name)
+        {
+            return Finalize(name, Decode(name));
+        }
+
+        static TextureArrayData Decode(const std::string& name);
+
+        static std::shared_ptr<TextureArray> Finalize(const std::string& name, TextureArrayData&& data)
+        {
+            if (data.layers.empty())
+                return nullptr;
+            return std::make_shared<TextureArray>(data);
+        }
+
+        // RGBA8 texels plus a third for the mipmaps
+        static std::size_t GetSize(const TextureArray& textureArray)
+        {
+            return static_cast<std::size_t>(textureArray.m_width) * textureArray.m_height * textureArray.GetLayerCount() * 4 * 4 / 3;
+        }
+    };
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <wv/assets/AssetArchive.h>
+#include <wv/rendering/Texture.h>
+#include <wv/wvpch.h>
+
+namespace WillowVox
+{
+    // On-disk cache of decoded, mipmapped textures, so a texture is only decoded again after its source file changes
+    // Entries are named by the hash of the source path and hold the source's size and modification time
+    class TextureCache
+    {
+    public:
+        // Directory to keep the cache in (e.g. "cache/textures"). Empty turns the cache off, which is the default
+        // Call before loading any textures
+        static void SetDirectory(const std::string& directory) { m_directory = directory; }
+        static const std::string& GetDirectory() { return m_directory; }
+        static bool IsEnabled() { return !m_directory.empty(); }
+
+        // Read the cached texture for a source file into texture. False if there is none or the source has changed
+        static bool Load(std::string_view sourcePath, const AssetFileInfo& source, TextureData& texture);
+        // Cache a decoded texture. Safe to call from several threads, even for the same texture
+        static void Store(std::string_view sourcePath, const AssetFileInfo& source, const TextureData& texture);
+
+    private:
+        static std::string GetCachePath(std::string_view sourcePath);
+
+        static std::string m_directory;
+    };
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <wv/rendering/Texture.h>
+#include <concurrentqueue.h>
+#include <wv/wvpch.h>
+#include <mutex>
+
+namespace WillowVox
+{
+    // Mapped memory handed out by TextureStreamer::Allocate
+    // Write pixels into data, then pass the region to Upload or Discard
+    // Images can be decoded straight into it with ImageDecodeOptions::destination
+    struct UploadRegion
+    {
+        unsigned char* data = nullptr;
+        std::size_t size = 0;
+
+        explicit operator bool() const { return data != nullptr; }
+
+    private:
+        friend class TextureStreamer;
+
+        int m_buffer = -1;
+        std::size_t m_offset = 0;
+        // Ring the region came from. Regions from before a Shutdown are ignored
+        uint32_t m_generation = 0;
+    };
+
+    // Streams pixels into textures through a ring of persistently mapped pixel buffers
+    // Any thread can write pixels straight into mapped memory, so the driver doesn't have to copy
+    // them out of client memory. The main thread issues the copies into the textures on Flush and
+    // fences each buffer, so it is only reused once the GPU has finished reading it
+    // Meant for textures generated at runtime, e.g. minimaps and dynamic atlases
+    class TextureStreamer
+    {
+    public:
+        // Map bufferCount buffers of bufferSize bytes each. Must be called on the main thread
+        static void Init(std::size_t bufferSize = 8 * 1024 * 1024, int bufferCount = 3);
+        // Unmap the buffers. Must be called on the main thread
+        // Stop the producers first (App::Shutdown is the place for it). Regions still held are waited on briefly,
+        // and if they aren't handed back their buffers are left mapped instead of being pulled from under the writers
+        static void Shutdown();
+        static bool IsInitialized();
+
+        // Reserve size bytes of mapped memory. Safe on any thread
+        // Returns an empty region if the streamer isn't initialized or the ring is full. In that case
+        // try again next frame, or upload from client memory with Texture::SetSubData
+        static UploadRegion Allocate(std::size_t size);
+        // Copy the region into part of the base level of texture on the next Flush. Safe on any thread
+        // The region holds tightly packed RGBA rows, width * height * 4 bytes
+        static void Upload(UploadRegion region, std::shared_ptr<Texture> texture, int x, int y, int width, int height);
+        // Give a region back without uploading it
+        static void Discard(UploadRegion region);
+
+        // Issue queued uploads and recycle buffers the GPU is done with
+        // Must be called on the main thread, once a frame
+        static void Flush();
+
+    private:
+        struct Buffer
+        {
+            unsigned int id = 0;
+            unsigned char* mapped = nullptr;
+            // Bytes handed out since the buffer was last recycled
+            std::size_t used = 0;
+            // Regions handed out but not uploaded or discarded yet
+            int outstanding = 0;
+            // GLsync placed after the last upload that read from this buffer
+            void* fence = nullptr;
+        };
+
+        struct PendingUpload
+        {
+            UploadRegion region;
+            std::shared_ptr<Texture> texture;
+            int x, y, width, height;
+        };
+
+        // Guards the ring. Pixels are written without holding it
+        static std::mutex m_mutex;
+        static std::vector<Buffer> m_buffers;
+        static uint32_t m_generation;
+        // Set while Shutdown waits for regions, so no new ones are handed out
+        static bool m_stopping;
+        static int m_current;
+        static std::size_t m_bufferSize;
+        static moodycamel::ConcurrentQueue<PendingUpload> m_uploads;
+    };
+}
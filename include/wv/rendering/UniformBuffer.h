@@ -0,0 +1,113 @@
+#pragma once
+
+#include <wv/wvpch.h>
+#include <cstddef>
+#include <optional>
+
+namespace WillowVox
+{
+    // std140 layout rules for the C++ side of uniform blocks
+    // Mirror a block with a struct, then check each member against the rules with WV_STD140_MEMBER
+    namespace Std140
+    {
+        // Base alignment of a block member of type T
+        template<typename T> inline constexpr std::size_t Alignment = 0;
+        template<> inline constexpr std::size_t Alignment<float> = 4;
+        template<> inline constexpr std::size_t Alignment<int> = 4;
+        template<> inline constexpr std::size_t Alignment<uint32_t> = 4;
+        template<> inline constexpr std::size_t Alignment<glm::vec2> = 8;
+        template<> inline constexpr std::size_t Alignment<glm::ivec2> = 8;
+        template<> inline constexpr std::size_t Alignment<glm::vec3> = 16;
+        template<> inline constexpr std::size_t Alignment<glm::ivec3> = 16;
+        template<> inline constexpr std::size_t Alignment<glm::vec4> = 16;
+        template<> inline constexpr std::size_t Alignment<glm::ivec4> = 16;
+        template<> inline constexpr std::size_t Alignment<glm::mat4> = 16;
+
+        // Offset of a member of type T placed right after previousEnd bytes of the block
+        template<typename T>
+        constexpr std::size_t NextOffset(std::size_t previousEnd)
+        {
+            static_assert(Alignment<T> != 0, "Type has no std140 layout rule");
+            return (previousEnd + Alignment<T> - 1) / Alignment<T> * Alignment<T>;
+        }
+
+        // Bytes a block takes in the buffer. Blocks are padded to a multiple of 16
+        constexpr std::size_t BlockSize(std::size_t end)
+        {
+            return (end + 15) / 16 * 16;
+        }
+    }
+
+    // Fails to compile if member of Type isn't where std140 puts it after previous
+#define WV_STD140_MEMBER(Type, member, previous) \
+    static_assert(offsetof(Type, member) == \
+        ::WillowVox::Std140::NextOffset<decltype(Type::member)>(offsetof(Type, previous) + sizeof(Type::previous)), \
+        #Type "::" #member " doesn't follow the std140 layout")
+
+    // GL buffer holding the data of uniform blocks
+    class UniformBuffer
+    {
+    public:
+        UniformBuffer(std::size_t size);
+        // Safe on any thread, the GL object is deleted through GLDeletionQueue
+        ~UniformBuffer();
+
+        UniformBuffer(UniformBuffer&& other) noexcept;
+        UniformBuffer& operator=(UniformBuffer&& other) noexcept;
+
+        void SetData(const void* data, std::size_t size, std::size_t offset = 0);
+        template<typename T>
+        void SetData(const T& data, std::size_t offset = 0) { SetData(&data, sizeof(T), offset); }
+
+        // Bind to a uniform block binding point. Every program with a block at that binding reads it
+        void Bind(unsigned int binding);
+        void BindRange(unsigned int binding, std::size_t offset, std::size_t size);
+
+        std::size_t GetSize() const { return m_size; }
+
+        // Offsets passed to BindRange must be a multiple of this
+        static std::size_t GetOffsetAlignment();
+
+    private:
+        unsigned int m_ubo;
+        std::size_t m_size;
+    };
+
+    // Persistently mapped uniform buffer for data that changes every draw
+    // Each draw's data is written straight into the mapping and bound with an offset, so thousands of
+    // draws share one buffer and no upload calls. The buffer is split into one section per frame in flight,
+    // and a section is only written again once the GPU has finished the frame that read it
+    class UniformRing
+    {
+    public:
+        // Room for frameSize bytes per frame. Must be created on the main thread
+        UniformRing(std::size_t frameSize, int frameCount = 3);
+        ~UniformRing();
+
+        UniformRing(const UniformRing&) = delete;
+        UniformRing& operator=(const UniformRing&) = delete;
+
+        // Copy data into this frame's section and return its offset, or nothing if the section is full
+        std::optional<std::size_t> Push(const void* data, std::size_t size);
+        template<typename T>
+        std::optional<std::size_t> Push(const T& data) { return Push(&data, sizeof(T)); }
+
+        // Bind size bytes at offset to a uniform block binding point for the next draws
+        void Bind(unsigned int binding, std::size_t offset, std::size_t size);
+
+        // Fence this frame's section and move on to the next one, waiting for the GPU if it still reads it
+        // Call once a frame after the last draw that uses the ring
+        void EndFrame();
+
+    private:
+        unsigned int m_ubo;
+        unsigned char* m_mapped;
+        std::size_t m_frameSize;
+        int m_frameCount;
+        int m_frame = 0;
+        // Bytes used in the current section
+        std::size_t m_used = 0;
+        // GLsync per section, placed after the last frame that used it
+        std::vector<void*> m_fences;
+    };
+}
@@ -9,7 +9,7 @@ namespace WillowVox
     {
     public:
         VertexArrayObject();
-        // Make sure the destructor only runs on the main thread
+        // Safe on any thread, the GL objects are deleted through GLDeletionQueue
         ~VertexArrayObject();
 
         void Bind();
@@ -22,7 +22,7 @@ namespace WillowVox
     public:
         VertexBuffer();
         VertexBuffer(VertexBuffer&& other) noexcept;
-        // Make sure destructor only runs on the main thread
+        // Safe on any thread, the GL object is deleted through GLDeletionQueue
         ~VertexBuffer();
 
         void Bind();
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <wv/wvpch.h>
+
+namespace WillowVox
+{
+    struct LogicalCpu
+    {
+        // OS index of the logical CPU, as used for affinity masks
+        int id;
+        // Physical core it belongs to. SMT siblings share this
+        int core;
+        // Socket it belongs to
+        int package;
+        // True for the slower cores of a hybrid CPU
+        bool efficiency;
+    };
+
+    struct PhysicalCore
+    {
+        int core;
+        int package;
+        bool efficiency;
+        // Logical CPUs (SMT siblings) of this core
+        std::vector<int> cpus;
+    };
+
+    // Logical CPUs and cores this process is allowed to run on
+    // Read from /sys on Linux, elsewhere every logical CPU is treated as its own core
+    class CpuTopology
+    {
+    public:
+        // Detected once and cached
+        static const CpuTopology& Get();
+
+        const std::vector<LogicalCpu>& GetLogicalCpus() const { return m_cpus; }
+        // Sorted by package, then core, so consecutive cores share a socket
+        const std::vector<PhysicalCore>& GetCores() const { return m_cores; }
+        int GetPackageCount() const { return m_packageCount; }
+        bool IsHybrid() const { return m_hybrid; }
+
+        // Logical CPU the calling thread is running on, or -1 if unknown
+        static int GetCurrentCpu();
+        // Index into GetCores() of the core that owns the given logical CPU, or -1
+        int FindCore(int cpu) const;
+
+        // Restrict the calling thread to the given logical CPUs
+        static bool PinCurrentThread(const std::vector<int>& cpus);
+        // Name the calling thread for debuggers and profilers. Linux truncates names to 15 characters
+        static void SetCurrentThreadName(const std::string& name);
+
+    private:
+        CpuTopology();
+        void Detect();
+
+        std::vector<LogicalCpu> m_cpus;
+        std::vector<PhysicalCore> m_cores;
+        int m_packageCount = 1;
+        bool m_hybrid = false;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,368 @@
+#pragma once
+
+#include <wv/threading/ThreadPool.h>
+#include <wv/threading/MainThreadQueue.h>
+#include <wv/wvpch.h>
+#include <atomic>
+#include <optional>
+#include <variant>
+#include <type_traits>
+
+namespace WillowVox
+{
+    namespace Detail
+    {
+        // A continuation waiting on a future. It only schedules the real work,
+        // so it is cheap to run on whichever thread completes the future
+        struct Continuation
+        {
+            Job schedule;
+            Continuation* next = nullptr;
+        };
+
+        // Marks the continuation list of a future that has already completed
+        inline Continuation* CompletedContinuations()
+        {
+            static Continuation completed;
+            return &completed;
+        }
+
+        template<typename T>
+        using FutureValue = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+        // Result type of a continuation F attached to a Future<T>
+        template<typename T, typename F>
+        struct ContinuationResult
+        {
+            using Type = std::decay_t<std::invoke_result_t<F&, T&>>;
+        };
+
+        template<typename F>
+        struct ContinuationResult<void, F>
+        {
+            using Type = std::decay_t<std::invoke_result_t<F&>>;
+        };
+
+        // State shared between a job and the futures waiting on it
+        // States are intrusively ref-counted and recycled through a per-thread free list,
+        // so submitting a job does not allocate once the free list is warm
+        template<typename T>
+        class FutureState
+        {
+        public:
+            static FutureState* Create(ThreadPool* pool)
+            {
+                FutureState* state = nullptr;
+                if (!t_freeListDestroyed)
+                {
+                    std::vector<FutureState*>& freeList = GetFreeList().states;
+                    if (!freeList.empty())
+                    {
+                        state = freeList.back();
+                        freeList.pop_back();
+                    }
+                }
+                if (!state)
+                    state = new FutureState();
+
+                state->m_refs.store(1, std::memory_order_relaxed);
+                state->m_ready.store(false, std::memory_order_relaxed);
+                state->m_continuations.store(nullptr, std::memory_order_relaxed);
+                state->m_pool = pool;
+                return state;
+            }
+
+            void AddRef()
+            {
+                m_refs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void Release()
+            {
+                if (m_refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    return;
+
+                m_value.reset();
+                if (!t_freeListDestroyed && GetFreeList().states.size() < MAX_FREE_STATES)
+                    GetFreeList().states.push_back(this);
+                else
+                    delete this;
+            }
+
+            template<typename... Args>
+            void SetValue(Args&&... args)
+            {
+                m_value.emplace(std::forward<Args>(args)...);
+                m_ready.store(true, std::memory_order_release);
+                m_ready.notify_all();
+
+                // Take the continuation list and reverse it so continuations run in the order they were attached
+                Continuation* list = m_continuations.exchange(CompletedContinuations(), std::memory_order_acq_rel);
+                Continuation* ordered = nullptr;
+                while (list)
+                {
+                    Continuation* next = list->next;
+                    list->next = ordered;
+                    ordered = list;
+                    list = next;
+                }
+
+                while (ordered)
+                {
+                    Continuation* next = ordered->next;
+                    ordered->schedule();
+                    delete ordered;
+                    ordered = next;
+                }
+            }
+
+            void AddContinuation(Job schedule)
+            {
+                Continuation* node = new Continuation{ std::move(schedule) };
+                Continuation* head = m_continuations.load(std::memory_order_acquire);
+                while (true)
+                {
+                    // Already completed, schedule right away
+                    if (head == CompletedContinuations())
+                    {
+                        node->schedule();
+                        delete node;
+                        return;
+                    }
+
+                    node->next = head;
+                    if (m_continuations.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_acquire))
+                        return;
+                }
+            }
+
+            bool IsReady() const { return m_ready.load(std::memory_order_acquire); }
+
+            void Wait() const
+            {
+                while (!m_ready.load(std::memory_order_acquire))
+                    m_ready.wait(false, std::memory_order_acquire);
+            }
+
+            FutureValue<T>& GetValue() { return *m_value; }
+            ThreadPool* GetPool() const { return m_pool; }
+
+        private:
+            static constexpr std::size_t MAX_FREE_STATES = 256;
+
+            struct FreeList
+            {
+                std::vector<FutureState*> states;
+
+                ~FreeList()
+                {
+                    t_freeListDestroyed = true;
+                    for (FutureState* state : states)
+                        delete state;
+                }
+            };
+
+            static FreeList& GetFreeList()
+            {
+                thread_local FreeList freeList;
+                return freeList;
+            }
+
+            // Set once the thread's free list is gone, e.g. for states released during thread exit
+            static inline thread_local bool t_freeListDestroyed = false;
+
+            std::atomic<uint32_t> m_refs;
+            std::atomic<bool> m_ready;
+            std::atomic<Continuation*> m_continuations;
+            std::optional<FutureValue<T>> m_value;
+            ThreadPool* m_pool;
+        };
+
+        // Run fn and store its result in state
+        template<typename R, typename F>
+        void Fulfill(FutureState<R>* state, F&& fn)
+        {
+            if constexpr (std::is_void_v<R>)
+            {
+                fn();
+                state->SetValue();
+            }
+            else
+                state->SetValue(fn());
+        }
+    }
+
+    // Handle to the result of a job submitted with ThreadPool::Submit
+    // Copies share the same result
+    template<typename T>
+    class Future
+    {
+    public:
+        Future() : m_state(nullptr) {}
+        // Takes ownership of one reference to state
+        explicit Future(Detail::FutureState<T>* state) : m_state(state) {}
+
+        Future(const Future& other) : m_state(other.m_state)
+        {
+            if (m_state)
+                m_state->AddRef();
+        }
+
+        Future(Future&& other) noexcept : m_state(other.m_state)
+        {
+            other.m_state = nullptr;
+        }
+
+        Future& operator=(Future other) noexcept
+        {
+            std::swap(m_state, other.m_state);
+            return *this;
+        }
+
+        ~Future()
+        {
+            if (m_state)
+                m_state->Release();
+        }
+
+        bool IsValid() const { return m_state != nullptr; }
+        bool IsReady() const { return m_state->IsReady(); }
+
+        // Blocks until the result is ready
+        // Don't wait on the thread the job needs to run on (e.g. a ThenOnMainThread future from the main thread)
+        void Wait() const { m_state->Wait(); }
+
+        // Blocks until the result is ready and returns it
+        std::add_lvalue_reference_t<T> Get() const
+        {
+            m_state->Wait();
+            if constexpr (!std::is_void_v<T>)
+                return m_state->GetValue();
+        }
+
+        // Run fn on the thread pool with the result once it is ready
+        // fn takes T& (or nothing for Future<void>) and its return value becomes the new future's result
+        template<typename F>
+        auto Then(F&& fn, Priority priority = Priority::Medium)
+        {
+            return Continue(std::forward<F>(fn), false, priority);
+        }
+
+        // Run fn on the main thread with the result once it is ready, e.g. to upload data to the GPU
+        template<typename F>
+        auto ThenOnMainThread(F&& fn)
+        {
+            return Continue(std::forward<F>(fn), true, Priority::Medium);
+        }
+
+    private:
+        template<typename F>
+        auto Continue(F&& fn, bool mainThread, Priority priority)
+        {
+            using R = typename Detail::ContinuationResult<T, std::decay_t<F>>::Type;
+
+            ThreadPool* pool = m_state->GetPool();
+            Detail::FutureState<T>* antecedent = m_state;
+            Detail::FutureState<R>* next = Detail::FutureState<R>::Create(pool);
+
+            // The continuation keeps both states alive until it has run
+            antecedent->AddRef();
+            next->AddRef();
+
+            antecedent->AddContinuation([antecedent, next, pool, mainThread, priority, fn = std::forward<F>(fn)]() mutable {
+                auto run = [antecedent, next, fn = std::move(fn)]() mutable {
+                    Detail::Fulfill(next, [&]() {
+                        if constexpr (std::is_void_v<T>)
+                            return fn();
+                        else
+                            return fn(antecedent->GetValue());
+                    });
+                    antecedent->Release();
+                    next->Release();
+                };
+
+                if (mainThread)
+                    MainThreadQueue::Post(std::move(run));
+                else if (pool)
+                    pool->Enqueue(std::move(run), priority);
+                else
+                    run();
+            });
+
+            return Future<R>(next);
+        }
+
+        Detail::FutureState<T>* m_state;
+    };
+
+    // Future that already holds value, e.g. for results that were cached
+    template<typename T>
+    Future<std::decay_t<T>> MakeReadyFuture(T&& value)
+    {
+        Detail::FutureState<std::decay_t<T>>* state = Detail::FutureState<std::decay_t<T>>::Create(nullptr);
+        state->SetValue(std::forward<T>(value));
+        return Future<std::decay_t<T>>(state);
+    }
+
+    // Future completed by hand, e.g. by work that is polled instead of running as one job
+    // Futures of a promise that is destroyed without a value never complete
+    // Without a pool, Then continuations run inline on the thread that sets the value
+    template<typename T>
+    class Promise
+    {
+    public:
+        Promise() : m_state(Detail::FutureState<T>::Create(nullptr)) {}
+        // Then continuations of the futures run on pool
+        explicit Promise(ThreadPool* pool) : m_state(Detail::FutureState<T>::Create(pool)) {}
+
+        Promise(Promise&& other) noexcept : m_state(other.m_state)
+        {
+            other.m_state = nullptr;
+        }
+
+        Promise& operator=(Promise other) noexcept
+        {
+            std::swap(m_state, other.m_state);
+            return *this;
+        }
+
+        ~Promise()
+        {
+            if (m_state)
+                m_state->Release();
+        }
+
+        Future<T> GetFuture() const
+        {
+            m_state->AddRef();
+            return Future<T>(m_state);
+        }
+
+        // Complete the futures. Only call this once
+        template<typename... Args>
+        void SetValue(Args&&... args)
+        {
+            m_state->SetValue(std::forward<Args>(args)...);
+        }
+
+    private:
+        Detail::FutureState<T>* m_state;
+    };
+
+    template<typename F>
+    auto ThreadPool::Submit(F&& fn, Priority priority) -> Future<std::decay_t<std::invoke_result_t<std::decay_t<F>&>>>
+    {
+        using R = std::decay_t<std::invoke_result_t<std::decay_t<F>&>>;
+
+        // One reference for the returned future and one for the job
+        Detail::FutureState<R>* state = Detail::FutureState<R>::Create(this);
+        state->AddRef();
+
+        Enqueue([state, fn = std::forward<F>(fn)]() mutable {
+            Detail::Fulfill(state, fn);
+            state->Release();
+        }, priority);
+
+        return Future<R>(state);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <wv/wvpch.h>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace WillowVox
+{
+    // Fixed-size blocks for jobs whose captures don't fit inline
+    // Freed blocks go to a per-thread free list and are reused, so the heap is only hit while the lists warm up
+    class JobAllocator
+    {
+    public:
+        static void* Allocate(std::size_t size);
+        static void Free(void* block, std::size_t size);
+
+        // Number of times a job's callable storage had to come from the heap instead of a free list
+        // Only covers the blocks handed out here. Queue blocks and future continuations aren't counted
+        static uint64_t GetBlockHeapAllocationCount() { return m_blockHeapAllocations.load(std::memory_order_relaxed); }
+
+    private:
+        static std::atomic<uint64_t> m_blockHeapAllocations;
+    };
+
+    // A move-only unit of work for ThreadPool
+    // Callables up to INLINE_SIZE bytes are stored inside the job itself, bigger ones in a JobAllocator block
+    class Job
+    {
+    public:
+        static constexpr std::size_t INLINE_SIZE = 64;
+
+        Job() noexcept : m_ops(nullptr) {}
+
+        template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Job> && std::is_invocable_v<std::decay_t<F>&>>>
+        Job(F&& fn)
+        {
+            using Fn = std::decay_t<F>;
+            if constexpr (FitsInline<Fn>())
+            {
+                new (m_storage) Fn(std::forward<F>(fn));
+                m_ops = &InlineOps<Fn>::ops;
+            }
+            else
+            {
+                void* block = JobAllocator::Allocate(sizeof(Fn));
+                new (block) Fn(std::forward<F>(fn));
+                *reinterpret_cast<void**>(m_storage) = block;
+                m_ops = &HeapOps<Fn>::ops;
+            }
+        }
+
+        Job(Job&& other) noexcept : m_ops(other.m_ops)
+        {
+            if (m_ops)
+            {
+                m_ops->move(m_storage, other.m_storage);
+                other.m_ops = nullptr;
+            }
+        }
+
+        Job& operator=(Job&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                m_ops = other.m_ops;
+                if (m_ops)
+                {
+                    m_ops->move(m_storage, other.m_storage);
+                    other.m_ops = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        Job(const Job&) = delete;
+        Job& operator=(const Job&) = delete;
+
+        ~Job() { Reset(); }
+
+        explicit operator bool() const { return m_ops != nullptr; }
+
+        void operator()() { m_ops->invoke(m_storage); }
+
+        void Reset()
+        {
+            if (m_ops)
+            {
+                m_ops->destroy(m_storage);
+                m_ops = nullptr;
+            }
+        }
+
+    private:
+        struct Ops
+        {
+            void (*invoke)(void* storage);
+            // Move-constructs into dst and destroys what is left in src
+            void (*move)(void* dst, void* src);
+            void (*destroy)(void* storage);
+        };
+
+        template<typename Fn>
+        static constexpr bool FitsInline()
+        {
+            return sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Fn>;
+        }
+
+        template<typename Fn>
+        struct InlineOps
+        {
+            static Fn* Get(void* storage) { return std::launder(reinterpret_cast<Fn*>(storage)); }
+
+            static void Invoke(void* storage) { (*Get(storage))(); }
+
+            static void Move(void* dst, void* src)
+            {
+                new (dst) Fn(std::move(*Get(src)));
+                Get(src)->~Fn();
+            }
+
+            static void Destroy(void* storage) { Get(storage)->~Fn(); }
+
+            static constexpr Ops ops = { &Invoke, &Move, &Destroy };
+        };
+
+        template<typename Fn>
+        struct HeapOps
+        {
+            static Fn* Get(void* storage) { return static_cast<Fn*>(*reinterpret_cast<void**>(storage)); }
+
+            static void Invoke(void* storage) { (*Get(storage))(); }
+
+            // Only the pointer moves
+            static void Move(void* dst, void* src) { *reinterpret_cast<void**>(dst) = *reinterpret_cast<void**>(src); }
+
+            static void Destroy(void* storage)
+            {
+                Fn* fn = Get(storage);
+                fn->~Fn();
+                JobAllocator::Free(fn, sizeof(Fn));
+            }
+
+            static constexpr Ops ops = { &Invoke, &Move, &Destroy };
+        };
+
+        alignas(std::max_align_t) unsigned char m_storage[INLINE_SIZE];
+        const Ops* m_ops;
+    };
+}
\ No newline at end of file
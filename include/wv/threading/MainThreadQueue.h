@@ -0,0 +1,38 @@
+#pragma once
+
+#include <concurrentqueue.h>
+#include <wv/threading/Job.h>
+#include <wv/wvpch.h>
+
+namespace WillowVox
+{
+    // Queue of jobs that must run on the main (GL) thread
+    // Any thread can post jobs. App::Run drains the queue once per frame, spending at most
+    // the frame budget on it. Jobs that don't fit in the budget carry over to the next frame
+    class MainThreadQueue
+    {
+    public:
+        // Marks the calling thread as the main thread
+        static void Init();
+        static bool IsMainThread();
+
+        // Queue a job to run on the main thread during the next drain
+        static void Post(Job job);
+
+        // Run jobs that were queued before the call until the frame budget is used up
+        // At least one job runs per call so the queue always makes progress. Must be called on the main thread
+        static void Drain();
+
+        // Time Drain may spend per frame in milliseconds. 0 or less means no limit
+        static void SetFrameBudget(double milliseconds) { m_frameBudgetMs = milliseconds; }
+        static double GetFrameBudget() { return m_frameBudgetMs; }
+
+        // Approximate number of jobs waiting to run
+        static std::size_t GetPendingCount() { return m_queue.size_approx(); }
+
+    private:
+        static moodycamel::ConcurrentQueue<Job> m_queue;
+        static std::thread::id m_mainThreadId;
+        static double m_frameBudgetMs;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <wv/threading/ThreadPool.h>
+#include <wv/wvpch.h>
+#include <algorithm>
+#include <atomic>
+
+namespace WillowVox
+{
+    namespace Detail
+    {
+        // Hands out chunks of a range to the threads working on it
+        // Chunks start large and shrink as the range runs out (guided scheduling), so when some
+        // parts of the range are much slower than others the small chunks at the end even it out
+        struct ParallelRange
+        {
+            ParallelRange(int64_t begin, int64_t end, int64_t grain, int participants)
+                : next(begin), end(end), total(end - begin), grain(grain), participants(participants) {}
+
+            bool Claim(int64_t& chunkBegin, int64_t& chunkEnd)
+            {
+                int64_t begin = next.load(std::memory_order_relaxed);
+                while (begin < end)
+                {
+                    int64_t remaining = end - begin;
+                    int64_t size = std::min(remaining, std::max(grain, remaining / (2 * participants)));
+                    if (next.compare_exchange_weak(begin, begin + size, std::memory_order_relaxed))
+                    {
+                        chunkBegin = begin;
+                        chunkEnd = begin + size;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void Finish(int64_t count)
+            {
+                if (completed.fetch_add(count, std::memory_order_acq_rel) + count == total)
+                    completed.notify_all();
+            }
+
+            void WaitForAll()
+            {
+                int64_t done = completed.load(std::memory_order_acquire);
+                while (done != total)
+                {
+                    completed.wait(done, std::memory_order_acquire);
+                    done = completed.load(std::memory_order_acquire);
+                }
+            }
+
+            std::atomic<int64_t> next;
+            std::atomic<int64_t> completed = 0;
+            const int64_t end;
+            const int64_t total;
+            const int64_t grain;
+            const int participants;
+        };
+
+        // Runs body(chunkBegin, chunkEnd, participant) over [begin, end) on the pool and the calling thread
+        // The caller works through chunks itself instead of blocking, and only waits for chunks other threads are still running
+        template<typename Body>
+        void RunParallel(ThreadPool& pool, int64_t begin, int64_t end, int64_t grain, int maxHelpers, Body& body)
+        {
+            if (begin >= end)
+                return;
+
+            grain = std::max<int64_t>(grain, 1);
+            int64_t chunks = (end - begin + grain - 1) / grain;
+            int helpers = static_cast<int>(std::min<int64_t>(maxHelpers, chunks - 1));
+
+            // Not worth handing out
+            if (helpers <= 0)
+            {
+                body(begin, end, 0);
+                return;
+            }
+
+            // Helpers that start after the range is used up only touch the shared state, never body,
+            // so the state is shared with them while body can stay on the caller's stack
+            auto range = std::make_shared<ParallelRange>(begin, end, grain, helpers + 1);
+            Body* bodyPtr = &body;
+            std::vector<Job> helperJobs;
+            helperJobs.reserve(helpers);
+            for (int i = 0; i < helpers; i++)
+            {
+                helperJobs.emplace_back([range, bodyPtr, participant = i + 1]() {
+                    int64_t chunkBegin, chunkEnd;
+                    while (range->Claim(chunkBegin, chunkEnd))
+                    {
+                        (*bodyPtr)(chunkBegin, chunkEnd, participant);
+                        range->Finish(chunkEnd - chunkBegin);
+                    }
+                });
+            }
+            pool.EnqueueBulk(helperJobs, Priority::High);
+
+            int64_t chunkBegin, chunkEnd;
+            while (range->Claim(chunkBegin, chunkEnd))
+            {
+                body(chunkBegin, chunkEnd, 0);
+                range->Finish(chunkEnd - chunkBegin);
+            }
+
+            range->WaitForAll();
+        }
+    }
+
+    // Calls fn(i) for every i in [begin, end) using the pool's workers and the calling thread
+    // grain is the smallest number of elements handed to a thread at once
+    template<typename Fn>
+    void ParallelFor(ThreadPool& pool, int64_t begin, int64_t end, int64_t grain, Fn&& fn)
+    {
+        auto body = [&fn](int64_t chunkBegin, int64_t chunkEnd, int) {
+            for (int64_t i = chunkBegin; i < chunkEnd; i++)
+                fn(i);
+        };
+        Detail::RunParallel(pool, begin, end, grain, pool.GetThreadCount(), body);
+    }
+
+    // Combines map(i) for every i in [begin, end) with reduce, starting from identity
+    // reduce must be associative. The order elements are combined in depends on how the range was split
+    template<typename T, typename MapFn, typename ReduceFn>
+    T ParallelReduce(ThreadPool& pool, int64_t begin, int64_t end, int64_t grain, T identity, MapFn&& map, ReduceFn&& reduce)
+    {
+        // One partial result per participating thread, the caller is participant 0
+        // Each sits on its own cache line so threads don't false-share
+        struct alignas(64) Partial { T value; };
+        int maxHelpers = pool.GetThreadCount();
+        std::vector<Partial> partials(maxHelpers + 1, Partial{ identity });
+
+        auto body = [&](int64_t chunkBegin, int64_t chunkEnd, int participant) {
+            T acc = identity;
+            for (int64_t i = chunkBegin; i < chunkEnd; i++)
+                acc = reduce(acc, map(i));
+            partials[participant].value = reduce(partials[participant].value, acc);
+        };
+        Detail::RunParallel(pool, begin, end, grain, maxHelpers, body);
+
+        T result = identity;
+        for (const Partial& partial : partials)
+            result = reduce(result, partial.value);
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <wv/threading/ThreadPool.h>
+#include <wv/wvpch.h>
+#include <atomic>
+#include <deque>
+
+namespace WillowVox
+{
+    // A set of jobs with dependencies between them
+    // Declare the nodes and edges once, then submit the graph as many times as needed.
+    // A node is enqueued as soon as all of its predecessors have finished
+    class TaskGraph
+    {
+    public:
+        using NodeId = uint32_t;
+        // Returned by AddNode when the node couldn't be added. AddEdge rejects it
+        static constexpr NodeId INVALID_NODE = static_cast<NodeId>(-1);
+
+        TaskGraph() = default;
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+        // Waits for a running submission to finish
+        ~TaskGraph();
+
+        // Returns INVALID_NODE if the graph is running
+        NodeId AddNode(const std::function<void()>& task, Priority priority = Priority::Medium);
+        // Makes "to" wait until "from" has finished
+        void AddEdge(NodeId from, NodeId to);
+
+        // Run every node on the given pool
+        // The graph can't be modified or submitted again until the submission has finished
+        void Submit(ThreadPool& pool);
+
+        bool IsDone() const;
+        // Blocks until every node of the current submission has finished
+        void Wait() const;
+
+        std::size_t GetNodeCount() const { return m_nodes.size(); }
+
+    private:
+        struct Node
+        {
+            std::function<void()> task;
+            Priority priority;
+            std::vector<NodeId> successors;
+            int predecessorCount = 0;
+            // Predecessors that still need to finish in the current submission
+            std::atomic<int> pending = 0;
+        };
+
+        // Completion state of a submission
+        // Shared with the running jobs, so the last one can signal it after the graph itself is gone
+        struct Completion
+        {
+            // Nodes that haven't finished yet
+            std::atomic<uint32_t> remaining = 0;
+        };
+
+        bool Validate();
+        void EnqueueNode(NodeId id, const std::shared_ptr<Completion>& completion);
+        void RunNode(NodeId id, const std::shared_ptr<Completion>& completion);
+
+        std::deque<Node> m_nodes;
+        // Nodes without predecessors. Rebuilt when the graph changes
+        std::vector<NodeId> m_roots;
+        bool m_dirty = true;
+
+        std::shared_ptr<Completion> m_completion = std::make_shared<Completion>();
+        ThreadPool* m_pool = nullptr;
+    };
+}
\ No newline at end of file
@@ -1,13 +1,17 @@
 #pragma once
 
 #include <concurrentqueue.h>
-#include <blockingconcurrentqueue.h>
+#include <lightweightsemaphore.h>
+#include <wv/threading/Job.h>
 #include <wv/wvpch.h>
 #include <atomic>
 #include <array>
+#include <span>
 
 namespace WillowVox
 {
+    template<typename T> class Future;
+
     enum class Priority {
         High = 0,
         Medium = 1,
@@ -15,23 +19,165 @@ namespace WillowVox
         Count = 3
     };
 
+    enum class SchedulingMode {
+        // Every worker pulls from the same shared queues
+        Shared,
+        // Jobs enqueued from a worker go to its own local queues,
+        // idle workers steal from the other workers
+        WorkStealing
+    };
+
+    struct PriorityStats
+    {
+        // Approximate number of jobs waiting to run
+        std::size_t queueDepth = 0;
+        uint64_t jobsRun = 0;
+        // Time between enqueue and a worker picking the job up
+        double averageWaitMs = 0.0;
+        double maxWaitMs = 0.0;
+    };
+
+    struct ThreadPoolStats
+    {
+        std::array<PriorityStats, static_cast<int>(Priority::Count)> priorities;
+    };
+
+    struct ThreadPoolOptions
+    {
+        // 0 picks one worker per physical core, minus the main thread's core if reserved
+        int numThreads = 0;
+        SchedulingMode mode = SchedulingMode::Shared;
+        // Pin each worker to the logical CPUs of one physical core
+        // Workers are handed cores in socket order, so neighbouring workers share caches
+        bool pinThreads = false;
+        // Keep workers off the core the main thread is running on
+        bool reserveMainCore = true;
+        // Also pin the calling (main) thread to its current core, so the reserved core stays its own
+        bool pinMainThread = false;
+        // Leave the efficiency cores of hybrid CPUs out when picking and pinning workers
+        bool performanceCoresOnly = false;
+        // Workers are named "<prefix> <index>" for debuggers and profilers
+        std::string namePrefix = "WV Worker";
+    };
+
     class ThreadPool
     {
     public:
         ThreadPool();
         ~ThreadPool();
-        void Start(int numThreads);
-        void Enqueue(const std::function<void()>& job, Priority priority = Priority::Medium);
+        void Start(int numThreads, SchedulingMode mode = SchedulingMode::Shared);
+        void Start(const ThreadPoolOptions& options);
+        int GetThreadCount() const { return static_cast<int>(m_threads.size()); }
+        void Enqueue(Job job, Priority priority = Priority::Medium);
+        // Enqueue many jobs with one queue operation and one wakeup. The jobs are moved out of the span
+        void EnqueueBulk(std::span<Job> jobs, Priority priority = Priority::Medium);
+
+        // Enqueue fn and get a future for its return value
+        // Defined in Future.h
+        template<typename F>
+        auto Submit(F&& fn, Priority priority = Priority::Medium) -> Future<std::decay_t<std::invoke_result_t<std::decay_t<F>&>>>;
+
+        // Queue depth and wait times per priority since the last ResetStats
+        ThreadPoolStats GetStats() const;
+        void ResetStats();
 
     private:
-        void ThreadLoop();
+        struct QueuedJob
+        {
+            Job job;
+            // Steady clock time the job was enqueued at, for wait time stats
+            int64_t enqueueTime = 0;
+        };
+
+        using JobQueue = moodycamel::ConcurrentQueue<QueuedJob>;
+
+        // Tokens a thread uses to enqueue into the shared queues, so its jobs go to its own sub-queue
+        struct ProducerTokens
+        {
+            ProducerTokens(std::array<JobQueue, static_cast<int>(Priority::Count)>& queues);
+
+            std::array<moodycamel::ProducerToken, static_cast<int>(Priority::Count)> tokens;
+        };
+
+        // Producer tokens of the threads that have enqueued into the shared queues
+        // Shared with those threads, so whichever of the pool and the thread goes first releases the tokens
+        struct ProducerRegistry
+        {
+            std::mutex mutex;
+            // Cleared by the pool before its queues are destroyed, since tokens must not outlive them
+            bool alive = true;
+            std::unordered_map<ProducerTokens*, std::unique_ptr<ProducerTokens>> tokens;
+        };
+
+        struct Worker
+        {
+            Worker();
+
+            // Local queues for each priority, used in work-stealing mode. Only the owning worker enqueues into these
+            std::array<JobQueue, static_cast<int>(Priority::Count)> queues;
+            // Owner tokens so the worker pushes and pops its own sub-queue without contention
+            std::array<moodycamel::ProducerToken, static_cast<int>(Priority::Count)> tokens;
+            // State for picking a random victim to steal from
+            uint32_t rng;
+            // Number of jobs picked so far, selects the priority to look at first
+            uint32_t picks;
+            // Applied by the worker thread itself when it starts. Empty cpus leaves it unpinned
+            std::vector<int> cpus;
+            std::string name;
+
+            // Stats, only updated by the owning worker
+            std::array<std::atomic<uint64_t>, static_cast<int>(Priority::Count)> jobsRun;
+            std::array<std::atomic<uint64_t>, static_cast<int>(Priority::Count)> totalWaitNs;
+            std::array<std::atomic<uint64_t>, static_cast<int>(Priority::Count)> maxWaitNs;
+        };
+
+        void ThreadLoop(int workerIndex);
+        bool TryGetJob(int workerIndex, QueuedJob& job);
+        bool TryGetJob(int workerIndex, int priority, QueuedJob& job);
+        bool TrySteal(int workerIndex, int priority, QueuedJob& job);
+        void RecordWait(Worker& worker, int priority, const QueuedJob& job);
+        ProducerTokens& GetProducerTokens();
+        // Wake up to count sleeping workers
+        void WakeWorkers(int count);
 
         // Queues for each priority
-        std::array<moodycamel::ConcurrentQueue<std::function<void()>>, static_cast<int>(Priority::Count)> m_queues;
-        // Queue to wake up threads when a job is queued
-        moodycamel::BlockingConcurrentQueue<bool> m_signal;
+        std::array<JobQueue, static_cast<int>(Priority::Count)> m_queues;
+        // Sleeping workers wait on this. It is only signalled for workers that are actually asleep
+        moodycamel::LightweightSemaphore m_semaphore;
+        std::atomic<int> m_sleeping;
+
+        std::shared_ptr<ProducerRegistry> m_producers;
+        // Unique for every pool ever created, so a cached token is never used with a new pool at the same address
+        uint64_t m_id;
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        SchedulingMode m_mode;
 
         std::vector<std::thread> m_threads;
         std::atomic<bool> m_shouldTerminate;
+
+        // Pool and worker index of the current thread, if it is a worker
+        static thread_local ThreadPool* t_pool;
+        static thread_local int t_workerIndex;
+
+        // The calling thread's tokens for each pool it has enqueued into. Releases them when the thread exits
+        struct ProducerCache
+        {
+            struct Entry
+            {
+                uint64_t poolId;
+                ProducerTokens* tokens;
+                std::shared_ptr<ProducerRegistry> registry;
+            };
+
+            ~ProducerCache();
+
+            // Threads rarely use more than a couple of pools, so this is searched linearly
+            std::vector<Entry> entries;
+        };
+        static thread_local ProducerCache t_producerCache;
+        static std::atomic<uint64_t> s_nextId;
     };
-}
\ No newline at end of file
+}
+
+#include <wv/threading/Future.h>
\ No newline at end of file
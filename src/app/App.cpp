@@ -1,9 +1,12 @@
 #include <wv/app/App.h>
 
 #include <wv/Logger.h>
+#include <wv/rendering/GLDeletionQueue.h>
 #include <wv/rendering/Renderer.h>
+#include <wv/rendering/TextureStreamer.h>
 #include <wv/rendering/Window.h>
 #include <wv/input/Input.h>
+#include <wv/threading/MainThreadQueue.h>
 #include <iostream>
 
 namespace WillowVox
@@ -15,6 +18,7 @@ namespace WillowVox
     {
         Logger::EngineLog("Using WillowVox Engine");     
         
+        MainThreadQueue::Init();
         Renderer::Init();
         Window::InitWindow(appDefaultWindowX, appDefaultWindowY, appWindowName);
         auto& window = Window::GetInstance();
@@ -38,14 +42,27 @@ namespace WillowVox
             // Client app logic
             Update();
 
+            // Run work posted to the main thread, up to the frame budget
+            MainThreadQueue::Drain();
+
+            // Upload the camera and time once for every shader
+            Renderer::UpdateFrameConstants(currentFrame, m_deltaTime);
+
             Render();
 
             // End-of-frame steps
+            TextureStreamer::Flush();
+            GLDeletionQueue::Flush();
             Input::ResetStates();
             window.SwapBuffers();
             window.PollEvents();
         }
 
+        // Let the app stop its workers before the upload buffers are unmapped
+        Shutdown();
+
+        TextureStreamer::Shutdown();
+        GLDeletionQueue::Flush();
         Renderer::Shutdown();
     }
 }
\ No newline at end of file
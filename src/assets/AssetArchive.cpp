@@ -0,0 +1,135 @@
+#include <wv/assets/AssetArchive.h>
+
+#include <wv/Hash.h>
+#include <wv/Logger.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#ifdef PLATFORM_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace WillowVox
+{
+    AssetArchive::~AssetArchive()
+    {
+        Close();
+    }
+
+    bool AssetArchive::Open(const std::string& path)
+    {
+        Close();
+
+        // Map the whole archive
+#ifdef PLATFORM_WINDOWS
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            Logger::EngineError("Failed to open asset archive: %s", path.c_str());
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        HANDLE mapping = GetFileSizeEx(file, &size) ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!data)
+        {
+            Logger::EngineError("Failed to map asset archive: %s", path.c_str());
+            if (mapping)
+                CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        m_file = file;
+        m_mapping = mapping;
+        m_size = static_cast<std::size_t>(size.QuadPart);
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            Logger::EngineError("Failed to open asset archive: %s", path.c_str());
+            return false;
+        }
+
+        struct stat info;
+        void* data = fstat(file, &info) == 0 && info.st_size > 0 ? mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+        // The mapping stays valid after the file is closed
+        close(file);
+        if (data == MAP_FAILED)
+        {
+            Logger::EngineError("Failed to map asset archive: %s", path.c_str());
+            return false;
+        }
+
+        m_size = static_cast<std::size_t>(info.st_size);
+#endif
+        m_data = static_cast<const unsigned char*>(data);
+
+        std::error_code error;
+        m_modifiedTime = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+
+        // Check the header and table of contents
+        ArchiveHeader header;
+        if (m_size >= sizeof(header))
+            std::memcpy(&header, m_data, sizeof(header));
+        if (m_size < sizeof(header) || header.magic != ArchiveHeader::MAGIC || header.version != ArchiveHeader::VERSION ||
+            sizeof(header) + static_cast<uint64_t>(header.entryCount) * sizeof(ArchiveEntry) > m_size)
+        {
+            Logger::EngineError("Invalid asset archive: %s", path.c_str());
+            Close();
+            return false;
+        }
+
+        m_entries = std::span<const ArchiveEntry>(reinterpret_cast<const ArchiveEntry*>(m_data + sizeof(header)), header.entryCount);
+        for (const ArchiveEntry& entry : m_entries)
+        {
+            if (entry.offset > m_size || entry.size > m_size - entry.offset)
+            {
+                Logger::EngineError("Invalid asset archive: %s", path.c_str());
+                Close();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void AssetArchive::Close()
+    {
+        if (!m_data)
+            return;
+
+#ifdef PLATFORM_WINDOWS
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+
+        m_data = nullptr;
+        m_size = 0;
+        m_entries = {};
+    }
+
+    std::span<const unsigned char> AssetArchive::Find(std::string_view path) const
+    {
+        uint64_t hash = Hash64(path);
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), hash, [](const ArchiveEntry& entry, uint64_t hash) {
+            return entry.hash < hash;
+        });
+
+        if (it == m_entries.end() || it->hash != hash)
+            return {};
+        return std::span<const unsigned char>(m_data + it->offset, it->size);
+    }
+}
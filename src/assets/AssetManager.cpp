@@ -1,5 +1,9 @@
 #include <wv/assets/AssetManager.h>
 
+#include <wv/threading/MainThreadQueue.h>
+#include <filesystem>
+#include <fstream>
+
 namespace WillowVox
 {
     AssetManager& AssetManager::GetInstance()
@@ -7,4 +11,128 @@ namespace WillowVox
         static AssetManager instance;
         return instance;
     }
-}
\ No newline at end of file
+
+    bool AssetManager::MountArchive(const std::string& path)
+    {
+        return m_archive.Open(path);
+    }
+
+    bool AssetManager::EnableHotReload()
+    {
+        return m_watcher.Start("assets", [this](const std::string& path) {
+            // Reloads go through the main thread, since they end with swapping GPU objects
+            MainThreadQueue::Post([this, path]() {
+                std::lock_guard<std::mutex> lock(m_typesMutex);
+                for (auto& [type, provider] : m_AssetTypes)
+                    provider->ReloadFile(path, m_pool.load(std::memory_order_acquire));
+            });
+        });
+    }
+
+    void AssetManager::DisableHotReload()
+    {
+        m_watcher.Stop();
+    }
+
+    AssetFile AssetManager::OpenFile(std::string_view path)
+    {
+        std::span<const unsigned char> data = m_archive.Find(path);
+        if (data.data())
+            return AssetFile(data);
+
+        if (!m_looseFiles)
+            return AssetFile();
+
+        std::ifstream file("assets/" + std::string(path), std::ios::binary | std::ios::ate);
+        if (!file)
+            return AssetFile();
+
+        std::streamoff size = file.tellg();
+        if (size < 0)
+            return AssetFile();
+
+        std::vector<unsigned char> contents(static_cast<std::size_t>(size));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(contents.data()), contents.size()))
+            return AssetFile();
+
+        return AssetFile(std::move(contents));
+    }
+
+    std::optional<AssetFileInfo> AssetManager::GetFileInfo(std::string_view path)
+    {
+        std::span<const unsigned char> data = m_archive.Find(path);
+        if (data.data())
+            return AssetFileInfo{ data.size(), m_archive.GetModifiedTime() };
+
+        if (!m_looseFiles)
+            return std::nullopt;
+
+        std::error_code error;
+        std::filesystem::path file = "assets/" + std::string(path);
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(file, error);
+        if (error)
+            return std::nullopt;
+
+        uintmax_t size = std::filesystem::file_size(file, error);
+        if (error)
+            return std::nullopt;
+
+        return AssetFileInfo{ static_cast<uint64_t>(size), static_cast<int64_t>(time.time_since_epoch().count()) };
+    }
+
+    void AssetManager::SetMemoryBudget(std::size_t bytes)
+    {
+        m_budget.store(bytes, std::memory_order_relaxed);
+        EnforceBudget();
+    }
+
+    AssetCacheStats AssetManager::GetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_typesMutex);
+
+        AssetCacheStats total;
+        for (auto& [type, provider] : m_AssetTypes)
+        {
+            AssetCacheStats stats = provider->GetStats();
+            total.hits += stats.hits;
+            total.misses += stats.misses;
+            total.evictions += stats.evictions;
+            total.residentBytes += stats.residentBytes;
+            total.assetCount += stats.assetCount;
+        }
+        return total;
+    }
+
+    IAssetProvider* AssetManager::RegisterProvider(std::type_index type, std::unique_ptr<IAssetProvider> provider)
+    {
+        std::lock_guard<std::mutex> lock(m_typesMutex);
+        return m_AssetTypes.try_emplace(type, std::move(provider)).first->second.get();
+    }
+
+    void AssetManager::EnforceBudget()
+    {
+        std::size_t budget = m_budget.load(std::memory_order_relaxed);
+        if (budget == 0)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_typesMutex);
+        if (m_AssetTypes.empty())
+            return;
+
+        std::size_t resident = 0;
+        for (auto& [type, provider] : m_AssetTypes)
+            resident += provider->GetStats().residentBytes;
+
+        // Take turns between types until enough is freed or nothing more can be
+        std::size_t numTypes = m_AssetTypes.size();
+        auto it = std::next(m_AssetTypes.begin(), m_nextEvictType % numTypes);
+        for (std::size_t i = 0; i < numTypes && resident > budget; i++)
+        {
+            resident -= std::min(resident, it->second->Evict(resident - budget));
+            m_nextEvictType++;
+            if (++it == m_AssetTypes.end())
+                it = m_AssetTypes.begin();
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#include <wv/assets/AssetWatcher.h>
+
+#include <wv/Logger.h>
+#include <filesystem>
+#include <unordered_set>
+
+#ifdef PLATFORM_LINUX
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace WillowVox
+{
+    namespace
+    {
+        // Editors often write a file in several steps, so changes are collected for this long before reporting them
+        constexpr int SETTLE_TIME_MS = 50;
+    }
+
+    AssetWatcher::~AssetWatcher()
+    {
+        Stop();
+    }
+
+    bool AssetWatcher::Start(const std::string& root, Callback onChange)
+    {
+        Stop();
+
+#ifdef PLATFORM_LINUX
+        m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        m_stopEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_inotify < 0 || m_stopEvent < 0)
+        {
+            Logger::EngineError("Failed to start watching %s", root.c_str());
+            Stop();
+            return false;
+        }
+
+        m_root = root;
+        m_onChange = std::move(onChange);
+        AddWatches("");
+        if (m_directories.empty())
+        {
+            Logger::EngineError("Failed to start watching %s", root.c_str());
+            Stop();
+            return false;
+        }
+
+        m_thread = std::thread(&AssetWatcher::ThreadLoop, this);
+        return true;
+#else
+        Logger::EngineWarn("Watching asset files is only supported on Linux");
+        return false;
+#endif
+    }
+
+    void AssetWatcher::Stop()
+    {
+#ifdef PLATFORM_LINUX
+        if (m_thread.joinable())
+        {
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t written = write(m_stopEvent, &one, sizeof(one));
+            m_thread.join();
+        }
+
+        if (m_inotify >= 0)
+            close(m_inotify);
+        if (m_stopEvent >= 0)
+            close(m_stopEvent);
+        m_inotify = -1;
+        m_stopEvent = -1;
+        m_directories.clear();
+#endif
+    }
+
+    void AssetWatcher::AddWatches(const std::string& directory)
+    {
+#ifdef PLATFORM_LINUX
+        std::string path = directory.empty() ? m_root : m_root + "/" + directory;
+        // Editors that save by renaming a temporary file over the original show up as IN_MOVED_TO
+        int wd = inotify_add_watch(m_inotify, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0)
+            return;
+        m_directories[wd] = directory;
+
+        std::error_code error;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path, error))
+        {
+            if (entry.is_directory(error))
+            {
+                std::string name = entry.path().filename().string();
+                AddWatches(directory.empty() ? name : directory + "/" + name);
+            }
+        }
+#endif
+    }
+
+    void AssetWatcher::ThreadLoop()
+    {
+#ifdef PLATFORM_LINUX
+        alignas(inotify_event) char buffer[4096];
+        std::unordered_set<std::string> changed;
+
+        while (true)
+        {
+            // Sleep until something changes. Once it has, only wait a little for more changes before reporting them
+            pollfd fds[2] = { { m_inotify, POLLIN, 0 }, { m_stopEvent, POLLIN, 0 } };
+            int ready = poll(fds, 2, changed.empty() ? -1 : SETTLE_TIME_MS);
+            if (ready < 0)
+                continue;
+            if (fds[1].revents & POLLIN)
+                return;
+
+            if (ready == 0)
+            {
+                for (const std::string& path : changed)
+                    m_onChange(path);
+                changed.clear();
+                continue;
+            }
+
+            ssize_t length;
+            while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* event = buffer; event < buffer + length; event += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(event)->len)
+                {
+                    const inotify_event& info = *reinterpret_cast<inotify_event*>(event);
+                    auto directory = m_directories.find(info.wd);
+                    if (info.len == 0 || directory == m_directories.end())
+                        continue;
+
+                    std::string path = directory->second.empty() ? info.name : directory->second + "/" + info.name;
+                    if (info.mask & IN_ISDIR)
+                    {
+                        // Watch new directories too
+                        if (info.mask & (IN_CREATE | IN_MOVED_TO))
+                            AddWatches(path);
+                    }
+                    else if (info.mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                        changed.insert(path);
+                }
+            }
+        }
+#endif
+    }
+}
@@ -1,4 +1,5 @@
 #include <wv/rendering/ElementBuffer.h>
+#include <wv/rendering/GLDeletionQueue.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -17,7 +18,7 @@ namespace WillowVox
 
     ElementBuffer::~ElementBuffer()
     {
-        glDeleteBuffers(1, &m_ebo);
+        GLDeletionQueue::DeleteBuffer(m_ebo);
     }
 
     void ElementBuffer::Bind()
@@ -0,0 +1,86 @@
+#include <wv/rendering/GLDeletionQueue.h>
+
+#include <wv/threading/MainThreadQueue.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+namespace WillowVox
+{
+    moodycamel::ConcurrentQueue<unsigned int> GLDeletionQueue::m_buffers;
+    moodycamel::ConcurrentQueue<unsigned int> GLDeletionQueue::m_vertexArrays;
+    moodycamel::ConcurrentQueue<unsigned int> GLDeletionQueue::m_textures;
+    moodycamel::ConcurrentQueue<unsigned int> GLDeletionQueue::m_programs;
+
+    namespace
+    {
+        // Max number of handles passed to one glDelete* call
+        constexpr std::size_t BATCH_SIZE = 256;
+    }
+
+    void GLDeletionQueue::DeleteBuffer(unsigned int id)
+    {
+        if (id == 0)
+            return;
+
+        if (MainThreadQueue::IsMainThread())
+            glDeleteBuffers(1, &id);
+        else
+            m_buffers.enqueue(id);
+    }
+
+    void GLDeletionQueue::DeleteVertexArray(unsigned int id)
+    {
+        if (id == 0)
+            return;
+
+        if (MainThreadQueue::IsMainThread())
+            glDeleteVertexArrays(1, &id);
+        else
+            m_vertexArrays.enqueue(id);
+    }
+
+    void GLDeletionQueue::DeleteTexture(unsigned int id)
+    {
+        if (id == 0)
+            return;
+
+        if (MainThreadQueue::IsMainThread())
+            glDeleteTextures(1, &id);
+        else
+            m_textures.enqueue(id);
+    }
+
+    void GLDeletionQueue::DeleteProgram(unsigned int id)
+    {
+        if (id == 0)
+            return;
+
+        if (MainThreadQueue::IsMainThread())
+            glDeleteProgram(id);
+        else
+            m_programs.enqueue(id);
+    }
+
+    void GLDeletionQueue::Flush()
+    {
+        unsigned int ids[BATCH_SIZE];
+        std::size_t count;
+
+        // Vertex arrays first so buffers aren't still referenced by them
+        while ((count = m_vertexArrays.try_dequeue_bulk(ids, BATCH_SIZE)) > 0)
+            glDeleteVertexArrays(static_cast<GLsizei>(count), ids);
+
+        while ((count = m_buffers.try_dequeue_bulk(ids, BATCH_SIZE)) > 0)
+            glDeleteBuffers(static_cast<GLsizei>(count), ids);
+
+        while ((count = m_textures.try_dequeue_bulk(ids, BATCH_SIZE)) > 0)
+            glDeleteTextures(static_cast<GLsizei>(count), ids);
+
+        // Programs can only be deleted one at a time
+        while ((count = m_programs.try_dequeue_bulk(ids, BATCH_SIZE)) > 0)
+        {
+            for (std::size_t i = 0; i < count; i++)
+                glDeleteProgram(ids[i]);
+        }
+    }
+}
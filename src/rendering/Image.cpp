@@ -0,0 +1,135 @@
+#include <wv/rendering/Image.h>
+
+#include <wv/Logger.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <cstring>
+#include <fstream>
+
+namespace WillowVox
+{
+    Image Image::Decode(std::span<const unsigned char> file, const ImageDecodeOptions& options)
+    {
+        Image image;
+        if (options.channels < 0 || options.channels > 4)
+        {
+            Logger::EngineError("Images can't be decoded to %d channels", options.channels);
+            return image;
+        }
+
+        int fileChannels;
+        if (options.destination.empty())
+        {
+            // The flip flag is per thread here, since other workers may be decoding at the same time
+            stbi_set_flip_vertically_on_load_thread(options.flipVertically);
+            image.m_pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &image.m_width, &image.m_height,
+                &fileChannels, options.channels);
+            if (!image.m_pixels)
+                return image;
+
+            image.m_owned = true;
+            image.m_channels = options.channels ? options.channels : fileChannels;
+            image.m_stride = static_cast<std::size_t>(image.m_width) * image.m_channels;
+            return image;
+        }
+
+        // Check the destination is big enough before doing the work of decoding
+        int width, height;
+        if (!GetInfo(file, width, height, fileChannels))
+            return image;
+
+        int channels = options.channels ? options.channels : fileChannels;
+        std::size_t rowSize = static_cast<std::size_t>(width) * channels;
+        std::size_t stride = options.stride ? options.stride : rowSize;
+        if (stride < rowSize || stride * (height - 1) + rowSize > options.destination.size())
+        {
+            Logger::EngineError("Image of %dx%d with %d channels doesn't fit its %zu byte destination", width, height, channels,
+                options.destination.size());
+            return image;
+        }
+
+        // stb_image can only decode into its own buffer, so it is copied into the destination once
+        // The copy flips the rows too, which saves stb_image its own pass over the pixels to flip them
+        stbi_set_flip_vertically_on_load_thread(false);
+        unsigned char* decoded = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height,
+            &fileChannels, channels);
+        if (!decoded)
+            return image;
+
+        for (int y = 0; y < height; y++)
+        {
+            int sourceRow = options.flipVertically ? height - 1 - y : y;
+            std::memcpy(options.destination.data() + stride * y, decoded + rowSize * sourceRow, rowSize);
+        }
+        stbi_image_free(decoded);
+
+        image.m_pixels = options.destination.data();
+        image.m_width = width;
+        image.m_height = height;
+        image.m_channels = channels;
+        image.m_stride = stride;
+        return image;
+    }
+
+    Image Image::Load(const std::string& path, const ImageDecodeOptions& options)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return Image();
+
+        std::streamoff size = file.tellg();
+        if (size < 0)
+            return Image();
+
+        std::vector<unsigned char> bytes(static_cast<std::size_t>(size));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(bytes.data()), bytes.size()))
+            return Image();
+
+        return Decode(bytes, options);
+    }
+
+    bool Image::GetInfo(std::span<const unsigned char> file, int& width, int& height, int& channels)
+    {
+        return stbi_info_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels) != 0;
+    }
+
+    Image::~Image()
+    {
+        if (m_owned)
+            stbi_image_free(m_pixels);
+    }
+
+    Image::Image(Image&& other) noexcept
+        : m_pixels(other.m_pixels), m_width(other.m_width), m_height(other.m_height), m_channels(other.m_channels),
+          m_stride(other.m_stride), m_owned(other.m_owned)
+    {
+        other.m_pixels = nullptr;
+        other.m_owned = false;
+    }
+
+    Image& Image::operator=(Image&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_owned)
+                stbi_image_free(m_pixels);
+            m_pixels = other.m_pixels;
+            m_width = other.m_width;
+            m_height = other.m_height;
+            m_channels = other.m_channels;
+            m_stride = other.m_stride;
+            m_owned = other.m_owned;
+            other.m_pixels = nullptr;
+            other.m_owned = false;
+        }
+        return *this;
+    }
+
+    std::size_t Image::GetSize() const
+    {
+        if (!m_pixels)
+            return 0;
+        return m_stride * (m_height - 1) + static_cast<std::size_t>(m_width) * m_channels;
+    }
+}
@@ -1,11 +1,15 @@
 #include <wv/rendering/Renderer.h>
 
+#include <wv/rendering/Camera.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 namespace WillowVox
 {
     bool Renderer::m_vsyncEnabled = true;
+    Camera* Renderer::m_camera = nullptr;
+    FrameConstants Renderer::m_frameConstants = {};
+    std::unique_ptr<UniformBuffer> Renderer::m_frameBuffer;
 
     void Renderer::Init()
     {
@@ -23,13 +27,36 @@ namespace WillowVox
         glEnable(GL_CULL_FACE);
         glCullFace(GL_BACK);
         glFrontFace(GL_CW);
+
+        // Stays bound for the whole run, so programs never need to rebind it
+        m_frameBuffer = std::make_unique<UniformBuffer>(Std140::BlockSize(sizeof(FrameConstants)));
+        m_frameBuffer->Bind(FRAME_CONSTANTS_BINDING);
     }
 
     void Renderer::Shutdown()
     {
+        m_frameBuffer.reset();
         glfwTerminate();
     }
 
+    void Renderer::UpdateFrameConstants(float time, float deltaTime)
+    {
+        if (!m_frameBuffer)
+            return;
+
+        if (m_camera)
+        {
+            m_frameConstants.view = m_camera->GetViewMatrix();
+            m_frameConstants.projection = m_camera->GetProjectionMatrix();
+            m_frameConstants.viewProjection = m_frameConstants.projection * m_frameConstants.view;
+            m_frameConstants.cameraPosition = m_camera->m_position;
+        }
+        m_frameConstants.time = time;
+        m_frameConstants.deltaTime = deltaTime;
+
+        m_frameBuffer->SetData(m_frameConstants);
+    }
+
     float Renderer::GetTime()
     {
         return glfwGetTime();
@@ -1,6 +1,14 @@
 #include <wv/rendering/Shader.h>
 
+#include <wv/Hash.h>
 #include <wv/Logger.h>
+#include <wv/assets/AssetManager.h>
+#include <wv/rendering/GLDeletionQueue.h>
+#include <wv/rendering/ShaderCache.h>
+#include <wv/rendering/ShaderCompiler.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <glm/gtc/type_ptr.hpp>
@@ -9,6 +17,48 @@
 
 namespace WillowVox
 {
+    UniformStats Shader::m_stats;
+    std::mutex Shader::m_includesMutex;
+    std::unordered_map<std::string, std::vector<std::string>> Shader::m_includes;
+
+    namespace
+    {
+        // Source of uniform table generations, so a handle can tell the table it was resolved against changed
+        std::atomic<uint32_t> nextGeneration = 1;
+
+        // Bytes the setters write for a uniform of the given GL type
+        uint32_t GetShadowSize(unsigned int type)
+        {
+            switch (type)
+            {
+            case GL_FLOAT_VEC2:
+            case GL_INT_VEC2:
+                return 8;
+            case GL_FLOAT_VEC3:
+            case GL_INT_VEC3:
+                return 12;
+            case GL_FLOAT_VEC4:
+            case GL_INT_VEC4:
+                return 16;
+            case GL_FLOAT_MAT4:
+                return 64;
+            case GL_FLOAT_MAT2:
+            case GL_FLOAT_MAT3:
+            case GL_FLOAT_MAT2x3:
+            case GL_FLOAT_MAT2x4:
+            case GL_FLOAT_MAT3x2:
+            case GL_FLOAT_MAT3x4:
+            case GL_FLOAT_MAT4x2:
+            case GL_FLOAT_MAT4x3:
+                // No setters for these yet, so they are never shadowed
+                return 0;
+            default:
+                // Scalars, bools and samplers
+                return 4;
+            }
+        }
+    }
+
     std::shared_ptr<Shader> Shader::FromFiles(const char* vertexShaderPath, const char* fragmentShaderPath)
     {
         // 1. retrieve the vertex/fragment source code from filePath
@@ -39,121 +89,332 @@ namespace WillowVox
         {
             Logger::Error("Error reading shader source files: %s", e.what());
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
-
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        int success;
-        char infoLog[512];
-
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, nullptr);
-        glCompileShader(vertex);
-        // print compile errors if any
-        glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-        if (!success)
+
+        return std::make_shared<Shader>(CompileProgram(vertexCode.c_str(), fragmentCode.c_str(), vertexShaderPath, fragmentShaderPath));
+    }
+
+    std::shared_ptr<Shader> Shader::FromFiles(const std::string& name)
+    {
+        ShaderSource source = ReadFiles(name);
+        return Shader::FromSource(source.vertex.c_str(), source.fragment.c_str());
+    }
+
+    ShaderSource Shader::ReadFiles(const std::string& name)
+    {
+        // The stage's own file counts as included, so an include cycle back to it doesn't paste it in again
+        ShaderSource source;
+        std::string vertexPath = "shaders/" + name + ".vert";
+        std::vector<std::string> vertexIncluded = { vertexPath };
+        bool read = ReadSource(vertexPath, source.vertex, vertexIncluded);
+
+        std::string fragmentPath = "shaders/" + name + ".frag";
+        std::vector<std::string> fragmentIncluded = { fragmentPath };
+        read = read && ReadSource(fragmentPath, source.fragment, fragmentIncluded);
+
+        // Remember the included files, so editing one reloads this shader. Files that failed to
+        // read are kept too, so fixing a missing include also reloads it
+        std::vector<std::string> included;
+        for (const std::vector<std::string>* stage : { &vertexIncluded, &fragmentIncluded })
+        {
+            for (std::size_t i = 1; i < stage->size(); i++)
+            {
+                if (std::find(included.begin(), included.end(), (*stage)[i]) == included.end())
+                    included.push_back((*stage)[i]);
+            }
+        }
         {
-            glGetShaderInfoLog(vertex, 512, nullptr, infoLog);
-            Logger::Error("Error compiling vertex shader! (%s): %s", vertexShaderPath, infoLog);
+            std::lock_guard lock(m_includesMutex);
+            m_includes[name] = std::move(included);
         }
 
-        // fragment shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, nullptr);
-        glCompileShader(fragment);
-        // print compile errors if any
-        glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-        if (!success)
+        if (!read)
+            return ShaderSource();
+        return source;
+    }
+
+    std::vector<std::string> Shader::GetShadersIncluding(std::string_view path)
+    {
+        std::vector<std::string> names;
+        std::lock_guard lock(m_includesMutex);
+        for (const auto& [name, included] : m_includes)
         {
-            glGetShaderInfoLog(fragment, 512, nullptr, infoLog);
-            Logger::Error("Error compiling fragment shader! (%s): %s", fragmentShaderPath, infoLog);
+            if (std::find(included.begin(), included.end(), path) != included.end())
+                names.push_back(name);
         }
+        return names;
+    }
 
-        // shader program
-        unsigned int programId = glCreateProgram();
-        glAttachShader(programId, vertex);
-        glAttachShader(programId, fragment);
-        glLinkProgram(programId);
-        // print linking errors if any
-        glGetProgramiv(programId, GL_LINK_STATUS, &success);
-        if (!success)
+    bool Shader::ReadSource(const std::string& path, std::string& output, std::vector<std::string>& included)
+    {
+        AssetFile file = AssetManager::GetInstance().OpenFile(path);
+        if (!file)
         {
-            glGetProgramInfoLog(programId, 512, nullptr, infoLog);
-            Logger::Error("Error linking shader program: %s", infoLog);
+            Logger::Error("Error reading shader source file: %s", path.c_str());
+            return false;
         }
 
-        // delete the shaders
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+        std::string_view contents(reinterpret_cast<const char*>(file.GetData().data()), file.GetData().size());
+        while (!contents.empty())
+        {
+            std::size_t end = contents.find('\n');
+            std::string_view line = contents.substr(0, end == std::string_view::npos ? contents.size() : end + 1);
+            contents.remove_prefix(line.size());
+
+            // Replace #include "file" lines with the file, relative to the shaders folder
+            std::string_view directive = line.substr(std::min(line.find_first_not_of(" \t"), line.size()));
+            if (!directive.starts_with("#include"))
+            {
+                output += line;
+                continue;
+            }
+
+            std::size_t open = directive.find('"');
+            std::size_t close = open == std::string_view::npos ? open : directive.find('"', open + 1);
+            if (close == std::string_view::npos)
+            {
+                Logger::Error("Bad #include in shader %s: %.*s", path.c_str(), static_cast<int>(directive.size()), directive.data());
+                return false;
+            }
+
+            // Each file is only included once per stage, which also stops include cycles
+            std::string includePath = "shaders/" + std::string(directive.substr(open + 1, close - open - 1));
+            if (std::find(included.begin(), included.end(), includePath) != included.end())
+                continue;
 
-        std::shared_ptr<Shader> shader = std::make_shared<Shader>(programId);
-        return shader;
+            included.push_back(includePath);
+            if (!ReadSource(includePath, output, included))
+                return false;
+            if (!output.empty() && output.back() != '\n')
+                output += '\n';
+        }
+
+        return true;
     }
 
-    std::shared_ptr<Shader> Shader::FromFiles(const std::string& name)
+    std::shared_ptr<Shader> Shader::FromSource(const char* vertexShaderCode, const char* fragmentShaderCode)
     {
-        std::string vertPath = "assets/shaders/" + name + ".vert";
-        std::string fragPath = "assets/shaders/" + name + ".frag";
-        return Shader::FromFiles(vertPath.c_str(), fragPath.c_str());
+        return std::make_shared<Shader>(CompileProgram(vertexShaderCode, fragmentShaderCode, vertexShaderCode, fragmentShaderCode));
     }
 
-    std::shared_ptr<Shader> Shader::FromSource(const char* vertexShaderCode, const char* fragmentShaderCode)
+    unsigned int Shader::CompileProgram(const char* vertexShaderCode, const char* fragmentShaderCode, const char* vertexName, const char* fragmentName)
+    {
+        // Skip compiling if this driver has linked these sources before
+        if (unsigned int cached = ShaderCache::Load(vertexShaderCode, fragmentShaderCode))
+            return cached;
+
+        ShaderCompiler::Program program = ShaderCompiler::Submit({ vertexShaderCode, fragmentShaderCode }, vertexName, fragmentName);
+        ShaderCompiler::Finish(program);
+        return program.program;
+    }
+
+    Shader::Shader(unsigned int programId) : _programId(programId)
+    {
+        ReflectUniforms();
+    }
+
+    Shader::~Shader()
+    {
+        GLDeletionQueue::DeleteProgram(_programId);
+    }
+
+    Shader::Shader(Shader&& other) noexcept
+        : _programId(other._programId), m_uniforms(std::move(other.m_uniforms)), m_generation(other.m_generation),
+          m_slots(std::move(other.m_slots)), m_values(std::move(other.m_values)), m_missing(std::move(other.m_missing))
+    {
+        other._programId = 0;
+        other.m_generation = 0;
+    }
+
+    Shader& Shader::operator=(Shader&& other) noexcept
     {
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        int success;
-        char infoLog[512];
-
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vertexShaderCode, nullptr);
-        glCompileShader(vertex);
-        // print compile errors if any
-        glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-        if (!success)
+        if (this != &other)
         {
-            glGetShaderInfoLog(vertex, 512, nullptr, infoLog);
-            Logger::Error("Error compiling vertex shader! (%s): %s", vertexShaderCode, infoLog);
+            GLDeletionQueue::DeleteProgram(_programId);
+            _programId = other._programId;
+            m_uniforms = std::move(other.m_uniforms);
+            m_generation = other.m_generation;
+            m_slots = std::move(other.m_slots);
+            m_values = std::move(other.m_values);
+            m_missing = std::move(other.m_missing);
+            other._programId = 0;
+            other.m_generation = 0;
         }
+        return *this;
+    }
+
+    void Shader::ReflectUniforms()
+    {
+        m_generation = nextGeneration.fetch_add(1, std::memory_order_relaxed);
+        if (_programId == 0)
+            return;
+
+        int linked = 0;
+        glGetProgramiv(_programId, GL_LINK_STATUS, &linked);
+        if (!linked)
+            return;
 
-        // fragment shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fragmentShaderCode, nullptr);
-        glCompileShader(fragment);
-        // print compile errors if any
-        glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-        if (!success)
+        int count = 0;
+        int maxLength = 0;
+        glGetProgramiv(_programId, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(_programId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::vector<char> buffer(std::max(maxLength, 1));
+        for (int i = 0; i < count; i++)
         {
-            glGetShaderInfoLog(fragment, 512, nullptr, infoLog);
-            Logger::Error("Error compiling fragment shader! (%s): %s", fragmentShaderCode, infoLog);
+            int length = 0;
+            int size = 0;
+            unsigned int type = 0;
+            glGetActiveUniform(_programId, i, maxLength, &length, &size, &type, buffer.data());
+
+            // Members of uniform blocks have no location
+            int location = glGetUniformLocation(_programId, buffer.data());
+            if (location == -1)
+                continue;
+
+            std::string_view name(buffer.data(), length);
+            if (!name.ends_with("[0]"))
+            {
+                m_uniforms.push_back({ Hash64(name), location, type, AddSlot(type) });
+                continue;
+            }
+
+            // Arrays are listed once as "name[0]". Add the bare name and every element
+            // The bare name is element 0, so they share a shadow slot
+            std::string base(name.substr(0, name.size() - 3));
+            int firstSlot = AddSlot(type);
+            m_uniforms.push_back({ Hash64(base), location, type, firstSlot });
+            for (int element = 0; element < size; element++)
+            {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                int elementLocation = glGetUniformLocation(_programId, elementName.c_str());
+                if (elementLocation != -1)
+                    m_uniforms.push_back({ Hash64(elementName), elementLocation, type, element == 0 ? firstSlot : AddSlot(type) });
+            }
         }
 
-        // shader program
-        unsigned int programId = glCreateProgram();
-        glAttachShader(programId, vertex);
-        glAttachShader(programId, fragment);
-        glLinkProgram(programId);
-        // print linking errors if any
-        glGetProgramiv(programId, GL_LINK_STATUS, &success);
-        if (!success)
+        std::sort(m_uniforms.begin(), m_uniforms.end(), [](const Uniform& a, const Uniform& b) { return a.hash < b.hash; });
+    }
+
+    int Shader::AddSlot(unsigned int type)
+    {
+        uint32_t size = GetShadowSize(type);
+        m_slots.push_back({ static_cast<uint32_t>(m_values.size()), size, false });
+        m_values.resize(m_values.size() + size);
+        return static_cast<int>(m_slots.size()) - 1;
+    }
+
+    int Shader::FindUniform(uint64_t hash) const
+    {
+        auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), hash,
+            [](const Uniform& uniform, uint64_t hash) { return uniform.hash < hash; });
+        if (it == m_uniforms.end() || it->hash != hash)
+            return -1;
+        return static_cast<int>(it - m_uniforms.begin());
+    }
+
+    int Shader::GetIndex(const char* name) const
+    {
+        int index = FindUniform(Hash64(name));
+        if (index == -1)
+            WarnMissing(name);
+        return index;
+    }
+
+    int Shader::GetIndex(UniformHandle uniform) const
+    {
+        return uniform.generation == m_generation ? uniform.index : FindUniform(uniform.hash);
+    }
+
+    void Shader::WarnMissing(const char* name) const
+    {
+#ifndef NDEBUG
+        // Setting a missing uniform does nothing, which usually means a typo or the compiler removed an unused uniform
+        uint64_t hash = Hash64(name);
+        if (std::find(m_missing.begin(), m_missing.end(), hash) != m_missing.end())
+            return;
+
+        m_missing.push_back(hash);
+        Logger::EngineWarn("Shader %u has no active uniform named %s", _programId, name);
+#endif
+    }
+
+    UniformHandle Shader::GetUniform(const char* name) const
+    {
+        UniformHandle uniform;
+        uniform.hash = Hash64(name);
+        uniform.generation = m_generation;
+        uniform.index = FindUniform(uniform.hash);
+        if (uniform.index == -1)
+            WarnMissing(name);
+        return uniform;
+    }
+
+    bool Shader::HasUniform(const char* name) const
+    {
+        return FindUniform(Hash64(name)) != -1;
+    }
+
+    bool Shader::UpdateShadow(int index, const void* value, std::size_t size) const
+    {
+        // Setting a missing uniform does nothing anyway
+        if (index == -1)
+            return false;
+
+        ValueSlot& slot = m_slots[m_uniforms[index].slot];
+        if (size != slot.size)
         {
-            glGetProgramInfoLog(programId, 512, nullptr, infoLog);
-            Logger::Error("Error linking shader program: %s", infoLog);
+            // The setter doesn't match the uniform's type, so let GL deal with it
+            m_stats.issued++;
+            return true;
         }
 
-        // delete the shaders
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+        unsigned char* shadow = m_values.data() + slot.offset;
+        if (slot.set && std::memcmp(shadow, value, size) == 0)
+        {
+            m_stats.skipped++;
+            return false;
+        }
 
-        std::shared_ptr<Shader> shader = std::make_shared<Shader>(programId);
-        return shader;
+        std::memcpy(shadow, value, size);
+        slot.set = true;
+        m_stats.issued++;
+        return true;
     }
 
-    Shader::~Shader()
+    void Shader::SetIntAt(int index, int value) const
+    {
+        if (UpdateShadow(index, &value, sizeof(value)))
+            glProgramUniform1i(_programId, m_uniforms[index].location, value);
+    }
+
+    void Shader::SetFloatAt(int index, float value) const
+    {
+        if (UpdateShadow(index, &value, sizeof(value)))
+            glProgramUniform1f(_programId, m_uniforms[index].location, value);
+    }
+
+    void Shader::SetVec2At(int index, glm::vec2 value) const
+    {
+        if (UpdateShadow(index, glm::value_ptr(value), sizeof(value)))
+            glProgramUniform2f(_programId, m_uniforms[index].location, value.x, value.y);
+    }
+
+    void Shader::SetVec3At(int index, glm::vec3 value) const
     {
-        glDeleteProgram(_programId);
+        if (UpdateShadow(index, glm::value_ptr(value), sizeof(value)))
+            glProgramUniform3f(_programId, m_uniforms[index].location, value.x, value.y, value.z);
+    }
+
+    void Shader::SetVec4At(int index, glm::vec4 value) const
+    {
+        if (UpdateShadow(index, glm::value_ptr(value), sizeof(value)))
+            glProgramUniform4f(_programId, m_uniforms[index].location, value.x, value.y, value.z, value.w);
+    }
+
+    void Shader::SetMat4At(int index, const glm::mat4& value) const
+    {
+        if (UpdateShadow(index, glm::value_ptr(value), sizeof(value)))
+            glProgramUniformMatrix4fv(_programId, m_uniforms[index].location, 1, GL_FALSE, glm::value_ptr(value));
     }
 
     void Shader::Bind()
@@ -163,51 +424,93 @@ namespace WillowVox
 
     void Shader::SetBool(const char* name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(_programId, name), (int)value);
+        SetIntAt(GetIndex(name), (int)value);
     }
 
     void Shader::SetInt(const char* name, int value) const
     {
-        glUniform1i(glGetUniformLocation(_programId, name), value);
+        SetIntAt(GetIndex(name), value);
     }
 
     void Shader::SetFloat(const char* name, float value) const
     {
-        glUniform1f(glGetUniformLocation(_programId, name), value);
+        SetFloatAt(GetIndex(name), value);
     }
 
     void Shader::SetVec2(const char* name, glm::vec2 value) const
     {
-        glUniform2f(glGetUniformLocation(_programId, name), value.x, value.y);
+        SetVec2At(GetIndex(name), value);
     }
 
     void Shader::SetVec2(const char* name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(_programId, name), x, y);
+        SetVec2At(GetIndex(name), glm::vec2(x, y));
     }
 
     void Shader::SetVec3(const char* name, glm::vec3 value) const
     {
-        glUniform3f(glGetUniformLocation(_programId, name), value.x, value.y, value.z);
+        SetVec3At(GetIndex(name), value);
     }
 
     void Shader::SetVec3(const char* name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(_programId, name), x, y, z);
+        SetVec3At(GetIndex(name), glm::vec3(x, y, z));
     }
 
     void Shader::SetVec4(const char* name, glm::vec4 value) const
     {
-        glUniform4f(glGetUniformLocation(_programId, name), value.x, value.y, value.z, value.w);
+        SetVec4At(GetIndex(name), value);
     }
 
     void Shader::SetVec4(const char* name, float x, float y, float z, float w) const
     {
-        glUniform4f(glGetUniformLocation(_programId, name), x, y, z, w);
+        SetVec4At(GetIndex(name), glm::vec4(x, y, z, w));
     }
 
     void Shader::SetMat4(const char* name, glm::mat4 value) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(_programId, name), 1, GL_FALSE, glm::value_ptr(value));
+        SetMat4At(GetIndex(name), value);
+    }
+
+    void Shader::SetBool(UniformHandle uniform, bool value) const
+    {
+        SetIntAt(GetIndex(uniform), (int)value);
+    }
+
+    void Shader::SetInt(UniformHandle uniform, int value) const
+    {
+        SetIntAt(GetIndex(uniform), value);
+    }
+
+    void Shader::SetFloat(UniformHandle uniform, float value) const
+    {
+        SetFloatAt(GetIndex(uniform), value);
+    }
+
+    void Shader::SetVec2(UniformHandle uniform, glm::vec2 value) const
+    {
+        SetVec2At(GetIndex(uniform), value);
+    }
+
+    void Shader::SetVec3(UniformHandle uniform, glm::vec3 value) const
+    {
+        SetVec3At(GetIndex(uniform), value);
+    }
+
+    void Shader::SetVec4(UniformHandle uniform, glm::vec4 value) const
+    {
+        SetVec4At(GetIndex(uniform), value);
+    }
+
+    void Shader::SetMat4(UniformHandle uniform, glm::mat4 value) const
+    {
+        SetMat4At(GetIndex(uniform), value);
+    }
+
+    Future<std::shared_ptr<Shader>> AssetLoader<Shader>::FinalizeAsync(const std::string& name, ShaderSource&& source)
+    {
+        if (source.vertex.empty() || source.fragment.empty())
+            return MakeReadyFuture(std::shared_ptr<Shader>());
+        return ShaderCompiler::Compile(std::move(source), name);
     }
 }
\ No newline at end of file
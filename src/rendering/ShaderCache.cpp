@@ -0,0 +1,154 @@
+#include <wv/rendering/ShaderCache.h>
+
+#include <wv/Hash.h>
+#include <wv/Logger.h>
+#include <glad/glad.h>
+#include <filesystem>
+#include <fstream>
+
+namespace WillowVox
+{
+    std::string ShaderCache::m_directory;
+
+    namespace
+    {
+        struct CacheHeader
+        {
+            static constexpr uint32_t MAGIC = 0x42505657; // "WVPB"
+            static constexpr uint32_t VERSION = 1;
+
+            uint32_t magic;
+            uint32_t version;
+            // Guards against hash collisions between different sources
+            uint64_t sourceSize;
+            uint64_t driverHash;
+            // Binary format reported by the driver
+            uint32_t format;
+            uint32_t binarySize;
+        };
+
+        // Hash of the strings that identify the driver. A driver update invalidates every entry
+        uint64_t GetDriverHash()
+        {
+            static uint64_t hash = []() {
+                uint64_t hash = Hash64("");
+                for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION })
+                {
+                    const char* value = reinterpret_cast<const char*>(glGetString(name));
+                    hash = Hash64(value ? value : "", hash);
+                    hash = Hash64("\n", hash);
+                }
+                return hash;
+            }();
+            return hash;
+        }
+    }
+
+    bool ShaderCache::IsEnabled()
+    {
+        if (m_directory.empty())
+            return false;
+
+        static bool supported = []() {
+            int formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            if (formats == 0)
+                Logger::EngineWarn("The driver doesn't support program binaries, shaders won't be cached");
+            return formats > 0;
+        }();
+        return supported;
+    }
+
+    unsigned int ShaderCache::Load(std::string_view vertexSource, std::string_view fragmentSource)
+    {
+        if (!IsEnabled())
+            return 0;
+
+        std::ifstream file(GetCachePath(GetKey(vertexSource, fragmentSource)), std::ios::binary);
+        if (!file)
+            return 0;
+
+        CacheHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            header.magic != CacheHeader::MAGIC || header.version != CacheHeader::VERSION ||
+            header.sourceSize != vertexSource.size() + fragmentSource.size() || header.driverHash != GetDriverHash())
+            return 0;
+
+        std::vector<char> binary(header.binarySize);
+        if (!file.read(binary.data(), binary.size()))
+            return 0;
+
+        // The driver can still reject a binary, e.g. if it changed without its version string changing
+        unsigned int program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        int success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glDeleteProgram(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    void ShaderCache::Store(unsigned int program, std::string_view vertexSource, std::string_view fragmentSource)
+    {
+        if (!IsEnabled())
+            return;
+
+        int length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+
+        CacheHeader header = {
+            CacheHeader::MAGIC, CacheHeader::VERSION, vertexSource.size() + fragmentSource.size(), GetDriverHash(),
+            format, static_cast<uint32_t>(length)
+        };
+
+        // Write to a temporary file, then rename it over the entry, so a crash never leaves a partly written entry
+        std::string path = GetCachePath(GetKey(vertexSource, fragmentSource));
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.data(), length);
+            if (!file)
+            {
+                Logger::EngineWarn("Failed to write shader cache entry %s", tempPath.c_str());
+                file.close();
+                std::filesystem::remove(tempPath, error);
+                return;
+            }
+        }
+
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+            std::filesystem::remove(tempPath, error);
+    }
+
+    uint64_t ShaderCache::GetKey(std::string_view vertexSource, std::string_view fragmentSource)
+    {
+        // Hash the vertex source's length too, so moving text from one stage to the other changes the key
+        uint64_t vertexSize = vertexSource.size();
+        uint64_t hash = Hash64(vertexSource, GetDriverHash());
+        hash = Hash64(std::string_view(reinterpret_cast<const char*>(&vertexSize), sizeof(vertexSize)), hash);
+        return Hash64(fragmentSource, hash);
+    }
+
+    std::string ShaderCache::GetCachePath(uint64_t key)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.wvprog", static_cast<unsigned long long>(key));
+        return m_directory + "/" + name;
+    }
+}
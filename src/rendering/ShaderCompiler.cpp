@@ -0,0 +1,200 @@
+#include <wv/rendering/ShaderCompiler.h>
+
+#include <wv/Logger.h>
+#include <wv/rendering/ShaderCache.h>
+#include <wv/threading/MainThreadQueue.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <cstring>
+
+// Same value for the KHR and ARB versions of the extension
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace WillowVox
+{
+    std::vector<ShaderCompiler::PendingProgram> ShaderCompiler::m_pending;
+    bool ShaderCompiler::m_polling = false;
+
+    namespace
+    {
+        bool HasExtension(const char* name)
+        {
+            int count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (int i = 0; i < count; i++)
+            {
+                const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+                if (extension && std::strcmp(extension, name) == 0)
+                    return true;
+            }
+            return false;
+        }
+
+        // Looked up by hand, so this works whether or not glad was generated with the extension
+        bool DetectParallelCompile()
+        {
+            using MaxThreadsFn = void (*)(unsigned int);
+            MaxThreadsFn maxThreads = nullptr;
+            if (HasExtension("GL_KHR_parallel_shader_compile"))
+                maxThreads = reinterpret_cast<MaxThreadsFn>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+            else if (HasExtension("GL_ARB_parallel_shader_compile"))
+                maxThreads = reinterpret_cast<MaxThreadsFn>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+
+            if (!maxThreads)
+                return false;
+
+            // Let the driver pick how many threads to compile on
+            maxThreads(0xFFFFFFFF);
+            return true;
+        }
+    }
+
+    bool ShaderCompiler::IsParallel()
+    {
+        static bool parallel = DetectParallelCompile();
+        return parallel;
+    }
+
+    Future<std::shared_ptr<Shader>> ShaderCompiler::Compile(ShaderSource source, const std::string& name)
+    {
+        // Skip compiling if this driver has linked these sources before
+        if (unsigned int cached = ShaderCache::Load(source.vertex, source.fragment))
+            return MakeReadyFuture(std::make_shared<Shader>(cached));
+
+        std::string label = name.empty() ? "source" : name;
+        PendingProgram pending = { Submit(std::move(source), label + ".vert", label + ".frag") };
+        Future<std::shared_ptr<Shader>> future = pending.promise.GetFuture();
+        m_pending.push_back(std::move(pending));
+
+        // One poll job serves every pending program, so the driver is only asked once a frame
+        if (!m_polling)
+        {
+            m_polling = true;
+            MainThreadQueue::Post([]() { Poll(); });
+        }
+
+        return future;
+    }
+
+    std::vector<Future<std::shared_ptr<Shader>>> ShaderCompiler::CompileBatch(std::span<const ShaderSource> sources)
+    {
+        std::vector<Future<std::shared_ptr<Shader>>> futures;
+        futures.reserve(sources.size());
+        for (const ShaderSource& source : sources)
+            futures.push_back(Compile(source));
+        return futures;
+    }
+
+    ShaderCompiler::Program ShaderCompiler::Submit(ShaderSource source, std::string vertexName, std::string fragmentName)
+    {
+        Program program;
+        program.source = std::move(source);
+        program.vertexName = std::move(vertexName);
+        program.fragmentName = std::move(fragmentName);
+
+        const char* vertexCode = program.source.vertex.c_str();
+        const char* fragmentCode = program.source.fragment.c_str();
+
+        program.vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(program.vertex, 1, &vertexCode, nullptr);
+        glCompileShader(program.vertex);
+
+        program.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(program.fragment, 1, &fragmentCode, nullptr);
+        glCompileShader(program.fragment);
+
+        // Linking doesn't need the compile results, so it is queued right behind the compiles
+        program.program = glCreateProgram();
+        glAttachShader(program.program, program.vertex);
+        glAttachShader(program.program, program.fragment);
+        if (ShaderCache::IsEnabled())
+            glProgramParameteri(program.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program.program);
+
+        return program;
+    }
+
+    bool ShaderCompiler::Finish(Program& program)
+    {
+        int success;
+        char infoLog[512];
+
+        // print compile errors if any
+        glGetShaderiv(program.vertex, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(program.vertex, 512, nullptr, infoLog);
+            Logger::Error("Error compiling vertex shader! (%s): %s", program.vertexName.c_str(), infoLog);
+        }
+
+        glGetShaderiv(program.fragment, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(program.fragment, 512, nullptr, infoLog);
+            Logger::Error("Error compiling fragment shader! (%s): %s", program.fragmentName.c_str(), infoLog);
+        }
+
+        // print linking errors if any
+        glGetProgramiv(program.program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(program.program, 512, nullptr, infoLog);
+            Logger::Error("Error linking shader program: %s", infoLog);
+        }
+        else
+            ShaderCache::Store(program.program, program.source.vertex, program.source.fragment);
+
+        // delete the shaders
+        glDeleteShader(program.vertex);
+        glDeleteShader(program.fragment);
+        program.vertex = 0;
+        program.fragment = 0;
+
+        return success;
+    }
+
+    bool ShaderCompiler::IsComplete(const Program& program)
+    {
+        if (!IsParallel())
+            return true;
+
+        int complete = 0;
+        glGetProgramiv(program.program, GL_COMPLETION_STATUS_KHR, &complete);
+        return complete;
+    }
+
+    void ShaderCompiler::Poll()
+    {
+        // Take the finished programs out first, since completing their futures can start new compiles
+        std::vector<PendingProgram> finished;
+        for (std::size_t i = 0; i < m_pending.size();)
+        {
+            if (IsComplete(m_pending[i].program))
+            {
+                finished.push_back(std::move(m_pending[i]));
+                if (i + 1 != m_pending.size())
+                    m_pending[i] = std::move(m_pending.back());
+                m_pending.pop_back();
+            }
+            else
+                i++;
+        }
+
+        m_polling = !m_pending.empty();
+        if (m_polling)
+            MainThreadQueue::Post([]() { Poll(); });
+
+        for (PendingProgram& pending : finished)
+        {
+            if (Finish(pending.program))
+                pending.promise.SetValue(std::make_shared<Shader>(pending.program.program));
+            else
+            {
+                glDeleteProgram(pending.program.program);
+                pending.promise.SetValue(nullptr);
+            }
+        }
+    }
+}
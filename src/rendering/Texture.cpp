@@ -1,42 +1,130 @@
 #include <wv/rendering/Texture.h>
 
 #include <wv/Logger.h>
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <wv/assets/AssetManager.h>
+#include <wv/rendering/GLDeletionQueue.h>
+#include <wv/rendering/Image.h>
+#include <wv/rendering/TextureCache.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <filesystem>
 
 namespace WillowVox
 {
     std::shared_ptr<Texture> Texture::FromName(const std::string& name)
     {
-        // Base path without extension
-        std::string path = "assets/textures/" + name;
+        TextureData data = Decode(name);
+        if (data.pixels.empty())
+            return nullptr;
+
+        return FromData(data);
+    }
+
+    TextureData Texture::Decode(const std::string& name)
+    {
+        TextureData texture;
 
         // Get the file based on supported file formats
         // This is a little scuffed right now.
         // I did this because I want to separate the asset name from the asset path, but it's
         // a bit strange to implement with textures due to all of the possible file formats.
         // I haven't figured out what to do for assets yet but this system works for now.
-        if (std::filesystem::exists(path + ".png"))
-            return std::make_shared<Texture>((path + ".png").c_str());
-        else if (std::filesystem::exists(path + ".jpg"))
-            return std::make_shared<Texture>((path + ".jpg").c_str());
-        else if (std::filesystem::exists(path + ".jpeg"))
-            return std::make_shared<Texture>((path + ".jpeg").c_str());
-        else if (std::filesystem::exists(path + ".tga"))
-            return std::make_shared<Texture>((path + ".tga").c_str());
-        else if (std::filesystem::exists(path + ".bmp"))
-            return std::make_shared<Texture>((path + ".bmp").c_str());
-        else if (std::filesystem::exists(path + ".psd"))
-            return std::make_shared<Texture>((path + ".psd").c_str());
-        else if (std::filesystem::exists(path + ".hdr"))
-            return std::make_shared<Texture>((path + ".hdr").c_str());
-        else if (std::filesystem::exists(path + ".pic"))
-            return std::make_shared<Texture>((path + ".pic").c_str());
-        else
-            return nullptr;
+        // With an archive mounted, probing is only a lookup in its table of contents
+        AssetManager& assets = AssetManager::GetInstance();
+        std::optional<AssetFileInfo> info;
+        std::string path;
+        for (const char* extension : { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".psd", ".hdr", ".pic" })
+        {
+            path = "textures/" + name + extension;
+            info = assets.GetFileInfo(path);
+            if (info)
+                break;
+        }
+
+        if (!info)
+        {
+            Logger::Error("Failed to find texture: %s", name.c_str());
+            return texture;
+        }
+
+        // Skip decoding if the source hasn't changed since it was cached
+        if (TextureCache::Load(path, *info, texture))
+            return texture;
+
+        AssetFile file = assets.OpenFile(path);
+        if (!file)
+        {
+            Logger::Error("Failed to load texture: %s", path.c_str());
+            return texture;
+        }
+
+        // Always decode to RGBA since that is what the texture is uploaded as
+        Image image = Image::Decode(file.GetData(), { .channels = 4 });
+        if (!image)
+        {
+            Logger::Error("Failed to load texture: %s", path.c_str());
+            return texture;
+        }
+
+        // One copy out of stb_image's buffer, leaving room for the mip chain if it is going to be built
+        std::size_t size = image.GetSize();
+        if (TextureCache::IsEnabled())
+            texture.pixels.reserve(size + size / 3 + 64);
+        texture.pixels.assign(image.GetPixels(), image.GetPixels() + size);
+        texture.width = image.GetWidth();
+        texture.height = image.GetHeight();
+
+        if (TextureCache::IsEnabled())
+        {
+            GenerateMipmaps(texture);
+            TextureCache::Store(path, *info, texture);
+        }
+
+        return texture;
+    }
+
+    void Texture::GenerateMipmaps(TextureData& texture)
+    {
+        if (texture.mipLevels != 1 || texture.pixels.empty())
+            return;
+
+        // The whole chain is a third bigger than the base level
+        texture.pixels.reserve(texture.pixels.size() + texture.pixels.size() / 3 + 64);
+
+        int width = texture.width;
+        int height = texture.height;
+        std::size_t offset = 0;
+        while (width > 1 || height > 1)
+        {
+            int nextWidth = std::max(1, width / 2);
+            int nextHeight = std::max(1, height / 2);
+            std::size_t nextOffset = offset + static_cast<std::size_t>(width) * height * 4;
+            texture.pixels.resize(nextOffset + static_cast<std::size_t>(nextWidth) * nextHeight * 4);
+
+            // Average each 2x2 block. Odd edges reuse the last row or column
+            const unsigned char* src = texture.pixels.data() + offset;
+            unsigned char* dst = texture.pixels.data() + nextOffset;
+            for (int y = 0; y < nextHeight; y++)
+            {
+                int y0 = std::min(y * 2, height - 1);
+                int y1 = std::min(y * 2 + 1, height - 1);
+                for (int x = 0; x < nextWidth; x++)
+                {
+                    int x0 = std::min(x * 2, width - 1);
+                    int x1 = std::min(x * 2 + 1, width - 1);
+                    for (int c = 0; c < 4; c++)
+                    {
+                        int sum = src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c] +
+                                  src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c];
+                        dst[(y * nextWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                    }
+                }
+            }
+
+            offset = nextOffset;
+            width = nextWidth;
+            height = nextHeight;
+            texture.mipLevels++;
+        }
     }
 
     std::shared_ptr<Texture> Texture::FromData(const std::vector<unsigned char>& data, int width, int height)
@@ -44,24 +132,36 @@ namespace WillowVox
         return std::make_shared<Texture>(data, width, height);
     }
 
+    std::shared_ptr<Texture> Texture::FromData(const TextureData& data)
+    {
+        return std::make_shared<Texture>(data);
+    }
+
     std::vector<unsigned char> Texture::GetTextureData(const std::string& path, int& width, int& height)
     {
-        // Load texture data
-        stbi_set_flip_vertically_on_load(true);
+        std::vector<unsigned char> pixels;
+        Image image = Image::Load(path, { .channels = 4 });
+        if (!image)
+        {
+            Logger::Error("Failed to load texture: %s", path.c_str());
+            width = height = 0;
+            return pixels;
+        }
 
-        int nrChannels;
-        unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-        return std::vector<unsigned char>(data, data + (width * height * nrChannels));
+        width = image.GetWidth();
+        height = image.GetHeight();
+        pixels.assign(image.GetPixels(), image.GetPixels() + image.GetSize());
+        return pixels;
     }
 
     Texture::Texture(const char* path)
     {
-        // Load texture data
-        stbi_set_flip_vertically_on_load(true);
-
-        int nrChannels;
-        unsigned char* data = stbi_load(path, &m_width, &m_height, &nrChannels, 0);
-        if (data)
+        // Load texture data as RGBA, since that is what it is uploaded as
+        Image image = Image::Load(path, { .channels = 4 });
+        m_width = image.GetWidth();
+        m_height = image.GetHeight();
+        m_textureId = 0;
+        if (image)
         {
             // Create texture
             glGenTextures(1, &m_textureId);
@@ -73,16 +173,13 @@ namespace WillowVox
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
             // Set texture data
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.GetPixels());
             glGenerateMipmap(GL_TEXTURE_2D);
         }
         else
         {
             Logger::Error("Failed to load texture: %s", path);
         }
-
-        // Free texture data
-        stbi_image_free(data);
     }
 
     Texture::Texture(const std::vector<unsigned char>& data, int width, int height)
@@ -105,9 +202,90 @@ namespace WillowVox
         glGenerateMipmap(GL_TEXTURE_2D);
     }
 
+    Texture::Texture(const TextureData& data)
+    {
+        // Set texture dimensions
+        m_width = data.width;
+        m_height = data.height;
+
+        // Create texture
+        glGenTextures(1, &m_textureId);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_textureId);
+
+        // Set texture parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        if (data.mipLevels <= 1)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.pixels.data());
+            glGenerateMipmap(GL_TEXTURE_2D);
+            return;
+        }
+
+        // Upload the prebuilt mip chain as is
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, data.mipLevels - 1);
+        int width = m_width;
+        int height = m_height;
+        std::size_t offset = 0;
+        for (int level = 0; level < data.mipLevels; level++)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.pixels.data() + offset);
+            offset += static_cast<std::size_t>(width) * height * 4;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+    }
+
+    Texture::Texture(int width, int height)
+    {
+        // Set texture dimensions
+        m_width = width;
+        m_height = height;
+
+        // Create texture
+        glGenTextures(1, &m_textureId);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_textureId);
+
+        // Set texture parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        // Allocate the base level only
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
     Texture::~Texture()
     {
-        glDeleteTextures(1, &m_textureId);
+        GLDeletionQueue::DeleteTexture(m_textureId);
+    }
+
+    Texture::Texture(Texture&& other) noexcept
+        : m_width(other.m_width), m_height(other.m_height), m_textureId(other.m_textureId)
+    {
+        other.m_textureId = 0;
+    }
+
+    Texture& Texture::operator=(Texture&& other) noexcept
+    {
+        if (this != &other)
+        {
+            GLDeletionQueue::DeleteTexture(m_textureId);
+            m_width = other.m_width;
+            m_height = other.m_height;
+            m_textureId = other.m_textureId;
+            other.m_textureId = 0;
+        }
+        return *this;
+    }
+
+    void Texture::SetSubData(int x, int y, int width, int height, const unsigned char* pixels)
+    {
+        // Direct state access, so the texture bindings aren't disturbed
+        glTextureSubImage2D(m_textureId, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
     }
 
     void Texture::BindTexture(TexSlot slot)
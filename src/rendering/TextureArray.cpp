@@ -0,0 +1,178 @@
+#include <wv/rendering/TextureArray.h>
+
+#include <wv/Logger.h>
+#include <wv/assets/AssetManager.h>
+#include <wv/rendering/GLDeletionQueue.h>
+#include <wv/threading/Parallel.h>
+#include <glad/glad.h>
+#include <cctype>
+#include <cstring>
+
+namespace WillowVox
+{
+    TextureArrayData TextureArray::Decode(const std::vector<std::string>& names, ThreadPool* pool)
+    {
+        TextureArrayData data;
+        if (names.empty())
+            return data;
+
+        std::vector<TextureData> layers(names.size());
+        auto decodeLayer = [&](int64_t i) {
+            layers[i] = Texture::Decode(names[i]);
+        };
+
+        if (pool)
+            ParallelFor(*pool, 0, static_cast<int64_t>(names.size()), 1, decodeLayer);
+        else
+        {
+            for (int64_t i = 0; i < static_cast<int64_t>(names.size()); i++)
+                decodeLayer(i);
+        }
+
+        // Find the layer size from the first texture that loaded
+        for (const TextureData& layer : layers)
+        {
+            if (!layer.pixels.empty())
+            {
+                data.width = layer.width;
+                data.height = layer.height;
+                break;
+            }
+        }
+
+        if (data.width == 0)
+            return data;
+
+        // Pack the base levels back to back, so they upload in one call
+        std::size_t layerSize = static_cast<std::size_t>(data.width) * data.height * 4;
+        data.pixels.resize(layerSize * layers.size());
+        data.layers = names;
+        for (std::size_t i = 0; i < layers.size(); i++)
+        {
+            if (layers[i].pixels.empty())
+                continue;
+
+            if (layers[i].width != data.width || layers[i].height != data.height)
+            {
+                Logger::EngineError("Texture %s is %dx%d, but the other layers of its texture array are %dx%d", names[i].c_str(),
+                    layers[i].width, layers[i].height, data.width, data.height);
+                continue;
+            }
+
+            std::memcpy(data.pixels.data() + layerSize * i, layers[i].pixels.data(), layerSize);
+        }
+
+        return data;
+    }
+
+    std::vector<std::string> TextureArray::ReadManifest(const std::string& name)
+    {
+        std::vector<std::string> names;
+        AssetFile file = AssetManager::GetInstance().OpenFile("texture_arrays/" + name + ".txt");
+        if (!file)
+        {
+            Logger::Error("Failed to find texture array: %s", name.c_str());
+            return names;
+        }
+
+        std::string_view contents(reinterpret_cast<const char*>(file.GetData().data()), file.GetData().size());
+        while (!contents.empty())
+        {
+            std::size_t end = contents.find('\n');
+            std::string_view line = contents.substr(0, end);
+            contents.remove_prefix(end == std::string_view::npos ? contents.size() : end + 1);
+
+            // Trim whitespace, including the \r of Windows line endings
+            while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back())))
+                line.remove_suffix(1);
+            while (!line.empty() && std::isspace(static_cast<unsigned char>(line.front())))
+                line.remove_prefix(1);
+
+            if (!line.empty() && line.front() != '#')
+                names.emplace_back(line);
+        }
+
+        return names;
+    }
+
+    std::shared_ptr<TextureArray> TextureArray::FromNames(const std::vector<std::string>& names, ThreadPool* pool)
+    {
+        TextureArrayData data = Decode(names, pool);
+        if (data.layers.empty())
+            return nullptr;
+
+        return std::make_shared<TextureArray>(data);
+    }
+
+    TextureArray::TextureArray(const TextureArrayData& data)
+    {
+        m_width = data.width;
+        m_height = data.height;
+        m_layerCount = static_cast<int>(data.layers.size());
+        for (int i = 0; i < m_layerCount; i++)
+            m_layers.emplace(AssetId(data.layers[i]).hash, i);
+
+        int levels = 1;
+        while ((std::max(m_width, m_height) >> levels) > 0)
+            levels++;
+
+        // Create texture
+        glGenTextures(1, &m_textureId);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureId);
+
+        // Set texture parameters
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        // Set texture data, all layers at once
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, m_width, m_height, m_layerCount);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, m_width, m_height, m_layerCount, GL_RGBA, GL_UNSIGNED_BYTE, data.pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+
+    TextureArray::~TextureArray()
+    {
+        GLDeletionQueue::DeleteTexture(m_textureId);
+    }
+
+    TextureArray::TextureArray(TextureArray&& other) noexcept
+        : m_width(other.m_width), m_height(other.m_height), m_textureId(other.m_textureId),
+          m_layerCount(other.m_layerCount), m_layers(std::move(other.m_layers))
+    {
+        other.m_textureId = 0;
+    }
+
+    TextureArray& TextureArray::operator=(TextureArray&& other) noexcept
+    {
+        if (this != &other)
+        {
+            GLDeletionQueue::DeleteTexture(m_textureId);
+            m_width = other.m_width;
+            m_height = other.m_height;
+            m_textureId = other.m_textureId;
+            m_layerCount = other.m_layerCount;
+            m_layers = std::move(other.m_layers);
+            other.m_textureId = 0;
+        }
+        return *this;
+    }
+
+    void TextureArray::BindTexture(Texture::TexSlot slot)
+    {
+        // The slots are in order, so they map straight onto the texture units
+        glActiveTexture(GL_TEXTURE0 + slot);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureId);
+    }
+
+    int TextureArray::GetLayer(AssetId id) const
+    {
+        auto it = m_layers.find(id.hash);
+        return it != m_layers.end() ? it->second : -1;
+    }
+
+    TextureArrayData AssetLoader<TextureArray>::Decode(const std::string& name)
+    {
+        return TextureArray::Decode(TextureArray::ReadManifest(name), AssetManager::GetInstance().GetThreadPool());
+    }
+}
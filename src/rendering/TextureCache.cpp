@@ -0,0 +1,139 @@
+#include <wv/rendering/TextureCache.h>
+
+#include <wv/Hash.h>
+#include <wv/Logger.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace WillowVox
+{
+    std::string TextureCache::m_directory;
+
+    namespace
+    {
+        struct CacheHeader
+        {
+            static constexpr uint32_t MAGIC = 0x58545657; // "WVTX"
+            static constexpr uint32_t VERSION = 1;
+
+            uint32_t magic;
+            uint32_t version;
+            // Source file the texture was decoded from
+            uint64_t sourceSize;
+            int64_t sourceTime;
+            int32_t width;
+            int32_t height;
+            int32_t mipLevels;
+            // Always RGBA8 for now
+            uint32_t format;
+            uint64_t dataSize;
+        };
+
+        constexpr uint32_t FORMAT_RGBA8 = 0;
+        // Larger than any GL implementation allows, and small enough that sizes can't overflow
+        constexpr int32_t MAX_DIMENSION = 1 << 16;
+
+        // Bytes an RGBA8 mip chain with these dimensions takes, or 0 if they don't describe a valid chain
+        uint64_t GetMipChainSize(int32_t width, int32_t height, int32_t mipLevels)
+        {
+            if (width <= 0 || height <= 0 || width > MAX_DIMENSION || height > MAX_DIMENSION)
+                return 0;
+
+            // floor(log2(max(width, height))) + 1
+            int32_t maxLevels = 1;
+            for (int32_t size = std::max(width, height); size > 1; size /= 2)
+                maxLevels++;
+            if (mipLevels < 1 || mipLevels > maxLevels)
+                return 0;
+
+            uint64_t total = 0;
+            for (int32_t level = 0; level < mipLevels; level++)
+            {
+                total += static_cast<uint64_t>(width) * height * 4;
+                width = std::max(1, width / 2);
+                height = std::max(1, height / 2);
+            }
+            return total;
+        }
+    }
+
+    bool TextureCache::Load(std::string_view sourcePath, const AssetFileInfo& source, TextureData& texture)
+    {
+        if (!IsEnabled())
+            return false;
+
+        std::ifstream file(GetCachePath(sourcePath), std::ios::binary);
+        if (!file)
+            return false;
+
+        CacheHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            header.magic != CacheHeader::MAGIC || header.version != CacheHeader::VERSION || header.format != FORMAT_RGBA8 ||
+            header.sourceSize != source.size || header.sourceTime != source.modifiedTime)
+            return false;
+
+        // The texture is uploaded straight from these pixels, so a corrupt entry must not claim more than it holds
+        uint64_t expectedSize = GetMipChainSize(header.width, header.height, header.mipLevels);
+        if (expectedSize == 0 || header.dataSize != expectedSize)
+        {
+            Logger::EngineWarn("Ignoring corrupt texture cache entry for %.*s",
+                static_cast<int>(sourcePath.size()), sourcePath.data());
+            return false;
+        }
+
+        // Everything after the header is the mip chain, read in one go
+        texture.pixels.resize(header.dataSize);
+        if (!file.read(reinterpret_cast<char*>(texture.pixels.data()), header.dataSize))
+        {
+            texture.pixels.clear();
+            return false;
+        }
+
+        texture.width = header.width;
+        texture.height = header.height;
+        texture.mipLevels = header.mipLevels;
+        return true;
+    }
+
+    void TextureCache::Store(std::string_view sourcePath, const AssetFileInfo& source, const TextureData& texture)
+    {
+        if (!IsEnabled())
+            return;
+
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+
+        CacheHeader header = {
+            CacheHeader::MAGIC, CacheHeader::VERSION, source.size, source.modifiedTime,
+            texture.width, texture.height, texture.mipLevels, FORMAT_RGBA8, texture.pixels.size()
+        };
+
+        // Write to a file of our own, then rename it over the entry, so readers never see a partly written entry
+        std::string path = GetCachePath(sourcePath);
+        std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(texture.pixels.data()), texture.pixels.size());
+            if (!file)
+            {
+                Logger::EngineWarn("Failed to write texture cache entry %s", tempPath.c_str());
+                file.close();
+                std::filesystem::remove(tempPath, error);
+                return;
+            }
+        }
+
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+            std::filesystem::remove(tempPath, error);
+    }
+
+    std::string TextureCache::GetCachePath(std::string_view sourcePath)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.wvtex", static_cast<unsigned long long>(Hash64(sourcePath)));
+        return m_directory + "/" + name;
+    }
+}
@@ -0,0 +1,247 @@
+#include <wv/rendering/TextureStreamer.h>
+
+#include <wv/Logger.h>
+#include <glad/glad.h>
+#include <chrono>
+#include <thread>
+
+namespace WillowVox
+{
+    std::mutex TextureStreamer::m_mutex;
+    std::vector<TextureStreamer::Buffer> TextureStreamer::m_buffers;
+    uint32_t TextureStreamer::m_generation = 1;
+    bool TextureStreamer::m_stopping = false;
+    int TextureStreamer::m_current = 0;
+    std::size_t TextureStreamer::m_bufferSize = 0;
+    moodycamel::ConcurrentQueue<TextureStreamer::PendingUpload> TextureStreamer::m_uploads;
+
+    namespace
+    {
+        // Regions start on this boundary, so workers writing neighbouring regions don't share cache lines
+        constexpr std::size_t REGION_ALIGNMENT = 256;
+        // Max number of uploads dequeued at once
+        constexpr std::size_t BATCH_SIZE = 64;
+        // How long Shutdown waits for producers to hand back their regions
+        constexpr auto SHUTDOWN_TIMEOUT = std::chrono::seconds(1);
+
+        bool IsSignaled(void* fence)
+        {
+            if (!fence)
+                return true;
+
+            GLenum result = glClientWaitSync(static_cast<GLsync>(fence), 0, 0);
+            return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+        }
+    }
+
+    void TextureStreamer::Init(std::size_t bufferSize, int bufferCount)
+    {
+        Shutdown();
+
+        std::lock_guard lock(m_mutex);
+        m_bufferSize = (bufferSize + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+        m_buffers.resize(std::max(bufferCount, 2));
+        m_current = 0;
+
+        // Coherent mappings make worker writes visible to every upload issued after them, without flushing
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        for (Buffer& buffer : m_buffers)
+        {
+            glGenBuffers(1, &buffer.id);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, m_bufferSize, nullptr, flags);
+            buffer.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_bufferSize, flags));
+            if (!buffer.mapped)
+                Logger::EngineError("Failed to map texture upload buffer");
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    void TextureStreamer::Shutdown()
+    {
+        std::unique_lock lock(m_mutex);
+        if (m_buffers.empty())
+            return;
+
+        // Wait for the regions still being written to. Queued uploads are done being written, so they are dropped
+        m_stopping = true;
+        auto deadline = std::chrono::steady_clock::now() + SHUTDOWN_TIMEOUT;
+        int outstanding;
+        while (true)
+        {
+            PendingUpload upload;
+            while (m_uploads.try_dequeue(upload))
+            {
+                if (upload.region.m_generation == m_generation)
+                    m_buffers[upload.region.m_buffer].outstanding--;
+            }
+
+            outstanding = 0;
+            for (const Buffer& buffer : m_buffers)
+                outstanding += buffer.outstanding;
+            if (outstanding == 0 || std::chrono::steady_clock::now() >= deadline)
+                break;
+
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            lock.lock();
+        }
+
+        if (outstanding != 0)
+            Logger::EngineWarn("%d texture upload regions weren't handed back before shutdown, leaving their buffers mapped", outstanding);
+
+        for (Buffer& buffer : m_buffers)
+        {
+            if (buffer.fence)
+                glDeleteSync(static_cast<GLsync>(buffer.fence));
+            // Deleting a buffer unmaps it, so buffers that are still being written to are leaked instead
+            if (buffer.outstanding == 0)
+                glDeleteBuffers(1, &buffer.id);
+        }
+        m_buffers.clear();
+
+        // Regions handed out before this point are ignored from now on
+        m_generation++;
+        m_stopping = false;
+    }
+
+    bool TextureStreamer::IsInitialized()
+    {
+        std::lock_guard lock(m_mutex);
+        return !m_buffers.empty();
+    }
+
+    UploadRegion TextureStreamer::Allocate(std::size_t size)
+    {
+        UploadRegion region;
+        std::lock_guard lock(m_mutex);
+        if (m_buffers.empty() || m_stopping || size == 0)
+            return region;
+
+        if (size > m_bufferSize)
+        {
+            Logger::EngineError("Texture upload of %zu bytes is larger than the upload buffers (%zu bytes)", size, m_bufferSize);
+            return region;
+        }
+
+        Buffer& buffer = m_buffers[m_current];
+        if (!buffer.mapped || buffer.used + size > m_bufferSize)
+            return region;
+
+        region.data = buffer.mapped + buffer.used;
+        region.size = size;
+        region.m_buffer = m_current;
+        region.m_offset = buffer.used;
+        region.m_generation = m_generation;
+
+        buffer.used = std::min(m_bufferSize, (buffer.used + size + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT);
+        buffer.outstanding++;
+        return region;
+    }
+
+    void TextureStreamer::Upload(UploadRegion region, std::shared_ptr<Texture> texture, int x, int y, int width, int height)
+    {
+        if (!region)
+            return;
+
+        if (!texture || width <= 0 || height <= 0 || static_cast<std::size_t>(width) * height * 4 > region.size)
+        {
+            Logger::EngineError("Invalid texture upload of %dx%d texels from a %zu byte region", width, height, region.size);
+            Discard(region);
+            return;
+        }
+
+        m_uploads.enqueue({ region, std::move(texture), x, y, width, height });
+    }
+
+    void TextureStreamer::Discard(UploadRegion region)
+    {
+        if (!region)
+            return;
+
+        std::lock_guard lock(m_mutex);
+        if (region.m_generation == m_generation)
+            m_buffers[region.m_buffer].outstanding--;
+    }
+
+    void TextureStreamer::Flush()
+    {
+        // The ring itself only changes on the main thread, so the copies are issued without holding the lock
+        if (m_buffers.empty())
+            return;
+
+        // Number of uploads issued from each buffer
+        std::vector<int> issued(m_buffers.size(), 0);
+        bool any = false;
+
+        PendingUpload batch[BATCH_SIZE];
+        int bound = -1;
+        std::size_t count;
+        while ((count = m_uploads.try_dequeue_bulk(batch, BATCH_SIZE)) != 0)
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                PendingUpload& upload = batch[i];
+                if (upload.region.m_generation != m_generation)
+                {
+                    upload.texture.reset();
+                    continue;
+                }
+
+                if (upload.region.m_buffer != bound)
+                {
+                    bound = upload.region.m_buffer;
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffers[bound].id);
+                }
+
+                // With a pixel unpack buffer bound, the pixel pointer is an offset into it
+                upload.texture->SetSubData(upload.x, upload.y, upload.width, upload.height,
+                    reinterpret_cast<const unsigned char*>(upload.region.m_offset));
+                issued[bound]++;
+                any = true;
+
+                upload.texture.reset();
+            }
+        }
+
+        if (bound != -1)
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        std::lock_guard lock(m_mutex);
+
+        // Fence every buffer that was read from, so it isn't recycled until the copies are done
+        if (any)
+        {
+            for (std::size_t i = 0; i < m_buffers.size(); i++)
+            {
+                if (issued[i] == 0)
+                    continue;
+
+                Buffer& buffer = m_buffers[i];
+                buffer.outstanding -= issued[i];
+                if (buffer.fence)
+                    glDeleteSync(static_cast<GLsync>(buffer.fence));
+                buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+        }
+
+        // Move on to the next buffer once this one has been written to
+        // The next one is only reused when every region in it has been handed back and the GPU is done reading it
+        // Otherwise keep filling what is left of the current one
+        if (m_buffers[m_current].used == 0)
+            return;
+
+        int next = (m_current + 1) % static_cast<int>(m_buffers.size());
+        Buffer& buffer = m_buffers[next];
+        if (buffer.outstanding != 0 || !IsSignaled(buffer.fence))
+            return;
+
+        if (buffer.fence)
+        {
+            glDeleteSync(static_cast<GLsync>(buffer.fence));
+            buffer.fence = nullptr;
+        }
+        buffer.used = 0;
+        m_current = next;
+    }
+}
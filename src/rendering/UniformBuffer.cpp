@@ -0,0 +1,145 @@
+#include <wv/rendering/UniformBuffer.h>
+
+#include <wv/Logger.h>
+#include <wv/rendering/GLDeletionQueue.h>
+#include <glad/glad.h>
+#include <cstring>
+
+namespace WillowVox
+{
+    UniformBuffer::UniformBuffer(std::size_t size) : m_size(size)
+    {
+        glCreateBuffers(1, &m_ubo);
+        glNamedBufferStorage(m_ubo, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    UniformBuffer::~UniformBuffer()
+    {
+        GLDeletionQueue::DeleteBuffer(m_ubo);
+    }
+
+    UniformBuffer::UniformBuffer(UniformBuffer&& other) noexcept
+        : m_ubo(other.m_ubo), m_size(other.m_size)
+    {
+        other.m_ubo = 0;
+    }
+
+    UniformBuffer& UniformBuffer::operator=(UniformBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            GLDeletionQueue::DeleteBuffer(m_ubo);
+            m_ubo = other.m_ubo;
+            m_size = other.m_size;
+            other.m_ubo = 0;
+        }
+        return *this;
+    }
+
+    void UniformBuffer::SetData(const void* data, std::size_t size, std::size_t offset)
+    {
+        if (offset + size > m_size)
+        {
+            Logger::EngineError("Uniform buffer write of %zu bytes at %zu is past its end (%zu bytes)", size, offset, m_size);
+            return;
+        }
+
+        glNamedBufferSubData(m_ubo, offset, size, data);
+    }
+
+    void UniformBuffer::Bind(unsigned int binding)
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_ubo);
+    }
+
+    void UniformBuffer::BindRange(unsigned int binding, std::size_t offset, std::size_t size)
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_ubo, offset, size);
+    }
+
+    std::size_t UniformBuffer::GetOffsetAlignment()
+    {
+        static std::size_t alignment = []() {
+            int value = 0;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+            return static_cast<std::size_t>(std::max(value, 1));
+        }();
+        return alignment;
+    }
+
+    UniformRing::UniformRing(std::size_t frameSize, int frameCount)
+        : m_frameCount(std::max(frameCount, 1)), m_fences(std::max(frameCount, 1), nullptr)
+    {
+        // Sections start on the binding alignment, so offsets of the first push in each are valid
+        std::size_t alignment = UniformBuffer::GetOffsetAlignment();
+        m_frameSize = (frameSize + alignment - 1) / alignment * alignment;
+
+        // Coherent, so writes are visible to draws issued after them without flushing
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &m_ubo);
+        glNamedBufferStorage(m_ubo, m_frameSize * m_frameCount, nullptr, flags);
+        m_mapped = static_cast<unsigned char*>(glMapNamedBufferRange(m_ubo, 0, m_frameSize * m_frameCount, flags));
+        if (!m_mapped)
+            Logger::EngineError("Failed to map uniform ring buffer");
+    }
+
+    UniformRing::~UniformRing()
+    {
+        for (void* fence : m_fences)
+        {
+            if (fence)
+                glDeleteSync(static_cast<GLsync>(fence));
+        }
+
+        // Deleting a buffer unmaps it
+        GLDeletionQueue::DeleteBuffer(m_ubo);
+    }
+
+    std::optional<std::size_t> UniformRing::Push(const void* data, std::size_t size)
+    {
+        if (!m_mapped || m_used + size > m_frameSize)
+        {
+            Logger::EngineError("Uniform ring is out of room for this frame (%zu bytes per frame)", m_frameSize);
+            return std::nullopt;
+        }
+
+        std::size_t offset = m_frameSize * m_frame + m_used;
+        std::memcpy(m_mapped + offset, data, size);
+
+        std::size_t alignment = UniformBuffer::GetOffsetAlignment();
+        m_used = std::min(m_frameSize, (m_used + size + alignment - 1) / alignment * alignment);
+        return offset;
+    }
+
+    void UniformRing::Bind(unsigned int binding, std::size_t offset, std::size_t size)
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_ubo, offset, size);
+    }
+
+    void UniformRing::EndFrame()
+    {
+        if (m_fences[m_frame])
+            glDeleteSync(static_cast<GLsync>(m_fences[m_frame]));
+        m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        m_frame = (m_frame + 1) % m_frameCount;
+        m_used = 0;
+
+        // Usually already signaled, since the section was last used frameCount frames ago
+        GLsync fence = static_cast<GLsync>(m_fences[m_frame]);
+        if (!fence)
+            return;
+
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (true)
+        {
+            GLenum result = glClientWaitSync(fence, flags, 1000000);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+                break;
+            flags = 0;
+        }
+
+        glDeleteSync(fence);
+        m_fences[m_frame] = nullptr;
+    }
+}
@@ -1,4 +1,5 @@
 #include <wv/rendering/VertexArrayObject.h>
+#include <wv/rendering/GLDeletionQueue.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -17,7 +18,7 @@ namespace WillowVox
 
     VertexArrayObject::~VertexArrayObject()
     {
-        glDeleteVertexArrays(1, &m_vao);
+        GLDeletionQueue::DeleteVertexArray(m_vao);
     }
 
     void VertexArrayObject::Bind()
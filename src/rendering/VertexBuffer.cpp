@@ -1,4 +1,5 @@
 #include <wv/rendering/VertexBuffer.h>
+#include <wv/rendering/GLDeletionQueue.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -17,7 +18,7 @@ namespace WillowVox
 
     VertexBuffer::~VertexBuffer()
     {
-        glDeleteBuffers(1, &m_vbo);
+        GLDeletionQueue::DeleteBuffer(m_vbo);
     }
 
     void VertexBuffer::Bind()
@@ -0,0 +1,235 @@
+#include <wv/threading/CpuTopology.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+#ifdef PLATFORM_LINUX
+#include <pthread.h>
+#include <sched.h>
+#elif defined(PLATFORM_WINDOWS)
+// Keep the min/max macros from breaking std::min and std::max
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#elif defined(PLATFORM_MACOS)
+#include <pthread.h>
+#endif
+
+namespace WillowVox
+{
+    namespace
+    {
+#ifdef PLATFORM_LINUX
+        // Read a single integer from a sysfs file
+        bool ReadInt(const std::string& path, int& value)
+        {
+            std::ifstream file(path);
+            return static_cast<bool>(file >> value);
+        }
+
+        // Parse a sysfs CPU list such as "0-3,8,10-11"
+        std::vector<int> ReadCpuList(const std::string& path)
+        {
+            std::vector<int> cpus;
+            std::ifstream file(path);
+            std::string list;
+            if (!std::getline(file, list))
+                return cpus;
+
+            std::size_t pos = 0;
+            while (pos < list.size())
+            {
+                std::size_t end = list.find(',', pos);
+                if (end == std::string::npos)
+                    end = list.size();
+
+                std::string range = list.substr(pos, end - pos);
+                std::size_t dash = range.find('-');
+                if (!range.empty())
+                {
+                    int first = std::stoi(range.substr(0, dash));
+                    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                    for (int cpu = first; cpu <= last; cpu++)
+                        cpus.push_back(cpu);
+                }
+
+                pos = end + 1;
+            }
+
+            return cpus;
+        }
+#elif defined(PLATFORM_WINDOWS)
+        using SetThreadDescriptionFn = HRESULT (WINAPI*)(HANDLE, PCWSTR);
+
+        // Only exists on Windows 10 1607 and later, so it is looked up instead of linked
+        SetThreadDescriptionFn GetSetThreadDescription()
+        {
+            static SetThreadDescriptionFn fn = []() -> SetThreadDescriptionFn {
+                HMODULE kernel = GetModuleHandleW(L"kernel32.dll");
+                if (!kernel)
+                    return nullptr;
+                return reinterpret_cast<SetThreadDescriptionFn>(GetProcAddress(kernel, "SetThreadDescription"));
+            }();
+            return fn;
+        }
+#endif
+    }
+
+    const CpuTopology& CpuTopology::Get()
+    {
+        static CpuTopology topology;
+        return topology;
+    }
+
+    CpuTopology::CpuTopology()
+    {
+        Detect();
+
+        // Fall back to treating every logical CPU as its own core
+        if (m_cpus.empty())
+        {
+            int count = std::max(1u, std::thread::hardware_concurrency());
+            for (int i = 0; i < count; i++)
+                m_cpus.push_back({ i, i, 0, false });
+        }
+
+        // Group SMT siblings into physical cores
+        std::map<std::pair<int, int>, PhysicalCore> cores;
+        for (const LogicalCpu& cpu : m_cpus)
+        {
+            PhysicalCore& core = cores[{ cpu.package, cpu.core }];
+            core.core = cpu.core;
+            core.package = cpu.package;
+            core.efficiency = cpu.efficiency;
+            core.cpus.push_back(cpu.id);
+        }
+
+        for (auto& [key, core] : cores)
+            m_cores.push_back(std::move(core));
+
+        int maxPackage = 0;
+        for (const LogicalCpu& cpu : m_cpus)
+            maxPackage = std::max(maxPackage, cpu.package);
+        m_packageCount = maxPackage + 1;
+    }
+
+    void CpuTopology::Detect()
+    {
+#ifdef PLATFORM_LINUX
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+            return;
+
+        // Intel hybrid CPUs list their efficiency cores here
+        std::vector<int> atomCpus = ReadCpuList("/sys/devices/cpu_atom/cpus");
+        // Other hybrid CPUs (e.g. ARM big.LITTLE) report a lower relative capacity for efficiency cores
+        std::vector<std::pair<int, int>> capacities;
+        int maxCapacity = 0;
+
+        for (int id = 0; id < CPU_SETSIZE; id++)
+        {
+            if (!CPU_ISSET(id, &allowed))
+                continue;
+
+            std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(id);
+            LogicalCpu cpu = { id, id, 0, false };
+            ReadInt(base + "/topology/core_id", cpu.core);
+            ReadInt(base + "/topology/physical_package_id", cpu.package);
+            cpu.package = std::max(cpu.package, 0);
+            cpu.efficiency = std::find(atomCpus.begin(), atomCpus.end(), id) != atomCpus.end();
+
+            int capacity;
+            if (ReadInt(base + "/cpu_capacity", capacity))
+            {
+                capacities.push_back({ id, capacity });
+                maxCapacity = std::max(maxCapacity, capacity);
+            }
+
+            m_cpus.push_back(cpu);
+        }
+
+        for (auto [id, capacity] : capacities)
+        {
+            if (capacity < maxCapacity)
+            {
+                for (LogicalCpu& cpu : m_cpus)
+                {
+                    if (cpu.id == id)
+                        cpu.efficiency = true;
+                }
+            }
+        }
+
+        for (const LogicalCpu& cpu : m_cpus)
+            m_hybrid |= cpu.efficiency;
+#endif
+    }
+
+    int CpuTopology::GetCurrentCpu()
+    {
+#ifdef PLATFORM_LINUX
+        return sched_getcpu();
+#elif defined(PLATFORM_WINDOWS)
+        return static_cast<int>(GetCurrentProcessorNumber());
+#else
+        return -1;
+#endif
+    }
+
+    int CpuTopology::FindCore(int cpu) const
+    {
+        for (int i = 0; i < static_cast<int>(m_cores.size()); i++)
+        {
+            if (std::find(m_cores[i].cpus.begin(), m_cores[i].cpus.end(), cpu) != m_cores[i].cpus.end())
+                return i;
+        }
+        return -1;
+    }
+
+    bool CpuTopology::PinCurrentThread(const std::vector<int>& cpus)
+    {
+        if (cpus.empty())
+            return false;
+
+#ifdef PLATFORM_LINUX
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+            CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(PLATFORM_WINDOWS)
+        // Only the first processor group is supported
+        DWORD_PTR mask = 0;
+        for (int cpu : cpus)
+        {
+            if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+                mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+        return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+        // macOS doesn't support pinning threads to cores
+        return false;
+#endif
+    }
+
+    void CpuTopology::SetCurrentThreadName(const std::string& name)
+    {
+#ifdef PLATFORM_LINUX
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#elif defined(PLATFORM_WINDOWS)
+        if (SetThreadDescriptionFn setDescription = GetSetThreadDescription())
+        {
+            std::wstring wideName(name.begin(), name.end());
+            setDescription(GetCurrentThread(), wideName.c_str());
+        }
+#elif defined(PLATFORM_MACOS)
+        pthread_setname_np(name.c_str());
+#endif
+    }
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <wv/threading/Job.h>
+
+#include <concurrentqueue.h>
+
+namespace WillowVox
+{
+    std::atomic<uint64_t> JobAllocator::m_blockHeapAllocations = 0;
+
+    namespace
+    {
+        // Block sizes handed out by the allocator. Anything bigger goes straight to the heap
+        constexpr std::size_t SIZE_CLASSES[] = { 128, 256, 512, 1024 };
+        constexpr int NUM_SIZE_CLASSES = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
+        // Blocks kept per size class and thread before they overflow into the shared pool
+        constexpr std::size_t MAX_FREE_BLOCKS = 32;
+
+        // Jobs are usually freed on a different thread than the one that created them,
+        // so blocks that don't fit in the freeing thread's list go back to a shared pool
+        struct SharedBlocks
+        {
+            moodycamel::ConcurrentQueue<void*> blocks[NUM_SIZE_CLASSES];
+
+            ~SharedBlocks()
+            {
+                destroyed = true;
+                void* block;
+                for (moodycamel::ConcurrentQueue<void*>& queue : blocks)
+                {
+                    while (queue.try_dequeue(block))
+                        ::operator delete(block);
+                }
+            }
+
+            // Static jobs in other translation units can outlive the pool
+            static inline bool destroyed = false;
+        } g_sharedBlocks;
+
+        int GetSizeClass(std::size_t size)
+        {
+            for (int i = 0; i < NUM_SIZE_CLASSES; i++)
+            {
+                if (size <= SIZE_CLASSES[i])
+                    return i;
+            }
+            return -1;
+        }
+
+        struct FreeLists
+        {
+            std::vector<void*> blocks[NUM_SIZE_CLASSES];
+
+            ~FreeLists()
+            {
+                destroyed = true;
+                for (std::vector<void*>& list : blocks)
+                {
+                    for (void* block : list)
+                        ::operator delete(block);
+                }
+            }
+
+            // Jobs can still be destroyed while the thread is exiting
+            static inline thread_local bool destroyed = false;
+        };
+
+        FreeLists& GetFreeLists()
+        {
+            thread_local FreeLists freeLists;
+            return freeLists;
+        }
+    }
+
+    void* JobAllocator::Allocate(std::size_t size)
+    {
+        int sizeClass = GetSizeClass(size);
+        if (sizeClass >= 0 && !FreeLists::destroyed)
+        {
+            std::vector<void*>& list = GetFreeLists().blocks[sizeClass];
+            if (!list.empty())
+            {
+                void* block = list.back();
+                list.pop_back();
+                return block;
+            }
+        }
+
+        void* block;
+        if (sizeClass >= 0 && !SharedBlocks::destroyed && g_sharedBlocks.blocks[sizeClass].try_dequeue(block))
+            return block;
+
+        m_blockHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(sizeClass >= 0 ? SIZE_CLASSES[sizeClass] : size);
+    }
+
+    void JobAllocator::Free(void* block, std::size_t size)
+    {
+        int sizeClass = GetSizeClass(size);
+        if (sizeClass >= 0 && !FreeLists::destroyed)
+        {
+            std::vector<void*>& list = GetFreeLists().blocks[sizeClass];
+            if (list.size() < MAX_FREE_BLOCKS)
+            {
+                list.push_back(block);
+                return;
+            }
+        }
+
+        if (sizeClass >= 0 && !SharedBlocks::destroyed)
+            g_sharedBlocks.blocks[sizeClass].enqueue(block);
+        else
+            ::operator delete(block);
+    }
+}
\ No newline at end of file
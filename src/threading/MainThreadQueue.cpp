@@ -0,0 +1,47 @@
+#include <wv/threading/MainThreadQueue.h>
+
+#include <chrono>
+
+namespace WillowVox
+{
+    moodycamel::ConcurrentQueue<Job> MainThreadQueue::m_queue;
+    std::thread::id MainThreadQueue::m_mainThreadId;
+    double MainThreadQueue::m_frameBudgetMs = 2.0;
+
+    void MainThreadQueue::Init()
+    {
+        m_mainThreadId = std::this_thread::get_id();
+    }
+
+    bool MainThreadQueue::IsMainThread()
+    {
+        return std::this_thread::get_id() == m_mainThreadId;
+    }
+
+    void MainThreadQueue::Post(Job job)
+    {
+        m_queue.enqueue(std::move(job));
+    }
+
+    void MainThreadQueue::Drain()
+    {
+        using Clock = std::chrono::steady_clock;
+        auto start = Clock::now();
+        auto budget = std::chrono::duration<double, std::milli>(m_frameBudgetMs);
+
+        // Jobs posted while draining (e.g. by the jobs themselves) wait for the next frame,
+        // so a job that keeps re-posting itself can't stall the frame
+        std::size_t count = m_queue.size_approx();
+
+        Job job;
+        for (std::size_t i = 0; i < count && m_queue.try_dequeue(job); i++)
+        {
+            if (job)
+                job();
+            job.Reset();
+
+            if (m_frameBudgetMs > 0.0 && Clock::now() - start >= budget)
+                break;
+        }
+    }
+}
\ No newline at end of file
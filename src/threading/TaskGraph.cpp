@@ -0,0 +1,162 @@
+#include <wv/threading/TaskGraph.h>
+
+#include <wv/Logger.h>
+
+namespace WillowVox
+{
+    TaskGraph::~TaskGraph()
+    {
+        Wait();
+    }
+
+    TaskGraph::NodeId TaskGraph::AddNode(const std::function<void()>& task, Priority priority)
+    {
+        if (!IsDone())
+        {
+            Logger::EngineError("Can't add a node to a task graph that is running");
+            return INVALID_NODE;
+        }
+
+        Node& node = m_nodes.emplace_back();
+        node.task = task;
+        node.priority = priority;
+        m_dirty = true;
+
+        return static_cast<NodeId>(m_nodes.size() - 1);
+    }
+
+    void TaskGraph::AddEdge(NodeId from, NodeId to)
+    {
+        if (!IsDone())
+        {
+            Logger::EngineError("Can't add an edge to a task graph that is running");
+            return;
+        }
+
+        if (from == INVALID_NODE || to == INVALID_NODE)
+        {
+            Logger::EngineError("Task graph edge references a node that failed to be added");
+            return;
+        }
+
+        if (from >= m_nodes.size() || to >= m_nodes.size())
+        {
+            Logger::EngineError("Task graph edge %u -> %u references a node that doesn't exist", from, to);
+            return;
+        }
+
+        m_nodes[from].successors.push_back(to);
+        m_nodes[to].predecessorCount++;
+        m_dirty = true;
+    }
+
+    void TaskGraph::Submit(ThreadPool& pool)
+    {
+        if (!IsDone())
+        {
+            Logger::EngineError("Task graph was submitted again before it finished");
+            return;
+        }
+
+        if (m_nodes.empty())
+            return;
+
+        if (m_dirty && !Validate())
+            return;
+
+        m_pool = &pool;
+
+        // Reuse the completion state unless a job of the previous submission is still holding on to it
+        if (m_completion.use_count() != 1)
+            m_completion = std::make_shared<Completion>();
+
+        // Reset the counters from the previous submission
+        for (Node& node : m_nodes)
+            node.pending.store(node.predecessorCount, std::memory_order_relaxed);
+        m_completion->remaining.store(static_cast<uint32_t>(m_nodes.size()), std::memory_order_release);
+
+        for (NodeId root : m_roots)
+            EnqueueNode(root, m_completion);
+    }
+
+    bool TaskGraph::IsDone() const
+    {
+        return m_completion->remaining.load(std::memory_order_acquire) == 0;
+    }
+
+    void TaskGraph::Wait() const
+    {
+        std::atomic<uint32_t>& counter = m_completion->remaining;
+        uint32_t remaining = counter.load(std::memory_order_acquire);
+        while (remaining != 0)
+        {
+            counter.wait(remaining, std::memory_order_acquire);
+            remaining = counter.load(std::memory_order_acquire);
+        }
+    }
+
+    bool TaskGraph::Validate()
+    {
+        m_roots.clear();
+
+        // Kahn's algorithm. If some node never runs out of predecessors, the graph has a cycle
+        std::vector<int> pending(m_nodes.size());
+        std::vector<NodeId> ready;
+        for (NodeId i = 0; i < m_nodes.size(); i++)
+        {
+            pending[i] = m_nodes[i].predecessorCount;
+            if (pending[i] == 0)
+            {
+                m_roots.push_back(i);
+                ready.push_back(i);
+            }
+        }
+
+        std::size_t visited = 0;
+        while (!ready.empty())
+        {
+            NodeId id = ready.back();
+            ready.pop_back();
+            visited++;
+
+            for (NodeId successor : m_nodes[id].successors)
+            {
+                if (--pending[successor] == 0)
+                    ready.push_back(successor);
+            }
+        }
+
+        if (visited != m_nodes.size())
+        {
+            Logger::EngineError("Task graph has a cycle, it will not be run");
+            return false;
+        }
+
+        m_dirty = false;
+        return true;
+    }
+
+    void TaskGraph::EnqueueNode(NodeId id, const std::shared_ptr<Completion>& completion)
+    {
+        m_pool->Enqueue([this, id, completion]() { RunNode(id, completion); }, m_nodes[id].priority);
+    }
+
+    void TaskGraph::RunNode(NodeId id, const std::shared_ptr<Completion>& completion)
+    {
+        Node& node = m_nodes[id];
+        if (node.task)
+            node.task();
+
+        // Release the successors that were only waiting on this node
+        for (NodeId successor : node.successors)
+        {
+            if (m_nodes[successor].pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                EnqueueNode(successor, completion);
+        }
+
+        // Wake up anyone waiting once the last node has finished
+        // The graph may be destroyed as soon as the count hits 0, so only the completion state is touched after it
+        if (completion->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            completion->remaining.notify_all();
+    }
+}
\ No newline at end of file
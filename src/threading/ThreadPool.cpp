@@ -1,69 +1,368 @@
 #include <wv/threading/ThreadPool.h>
 
 #include <wv/Logger.h>
+#include <wv/threading/CpuTopology.h>
+#include <algorithm>
+#include <chrono>
 
 namespace WillowVox
 {
+    thread_local ThreadPool* ThreadPool::t_pool = nullptr;
+    thread_local int ThreadPool::t_workerIndex = -1;
+    thread_local ThreadPool::ProducerCache ThreadPool::t_producerCache;
+    std::atomic<uint64_t> ThreadPool::s_nextId = 1;
+
+    namespace
+    {
+        // Priority each worker looks at first, cycled through pick by pick (weighted 4:2:1)
+        // Every priority gets looked at first regularly, so Low jobs still run under constant High load
+        constexpr int PRIORITY_SCHEDULE[] = { 0, 1, 0, 2, 0, 1, 0 };
+        constexpr int PRIORITY_SCHEDULE_LENGTH = sizeof(PRIORITY_SCHEDULE) / sizeof(PRIORITY_SCHEDULE[0]);
+
+        int64_t GetTimeNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    ThreadPool::Worker::Worker()
+        : tokens{ moodycamel::ProducerToken(queues[0]), moodycamel::ProducerToken(queues[1]), moodycamel::ProducerToken(queues[2]) },
+          rng(0), picks(0)
+    {
+        for (int i = 0; i < static_cast<int>(Priority::Count); i++)
+        {
+            jobsRun[i] = 0;
+            totalWaitNs[i] = 0;
+            maxWaitNs[i] = 0;
+        }
+    }
+
+    ThreadPool::ProducerTokens::ProducerTokens(std::array<JobQueue, static_cast<int>(Priority::Count)>& queues)
+        : tokens{ moodycamel::ProducerToken(queues[0]), moodycamel::ProducerToken(queues[1]), moodycamel::ProducerToken(queues[2]) } {}
+
+    ThreadPool::ProducerCache::~ProducerCache()
+    {
+        for (Entry& entry : entries)
+        {
+            std::lock_guard<std::mutex> lock(entry.registry->mutex);
+            if (entry.registry->alive)
+                entry.registry->tokens.erase(entry.tokens);
+        }
+    }
+
     ThreadPool::ThreadPool()
-        : m_shouldTerminate(false) {}
+        : m_sleeping(0), m_producers(std::make_shared<ProducerRegistry>()), m_id(s_nextId++),
+          m_mode(SchedulingMode::Shared), m_shouldTerminate(false) {}
 
     ThreadPool::~ThreadPool()
     {
         m_shouldTerminate = true;
 
         // Make sure all threads stop
-        for (int i = 0; i < m_threads.size() * 2; i++)
-            m_signal.enqueue(true);
+        m_semaphore.signal(static_cast<moodycamel::LightweightSemaphore::ssize_t>(m_threads.size()));
 
         // Join all threads
         for (std::thread& activeThread : m_threads)
             activeThread.join();
 
         m_threads.clear();
+        m_workers.clear();
+
+        // Release the tokens of threads that are still running, before the queues go
+        std::lock_guard<std::mutex> lock(m_producers->mutex);
+        m_producers->alive = false;
+        m_producers->tokens.clear();
     }
 
-    void ThreadPool::Start(int numThreads)
+    void ThreadPool::Start(int numThreads, SchedulingMode mode)
     {
+        ThreadPoolOptions options;
+        options.numThreads = numThreads;
+        options.mode = mode;
+        Start(options);
+    }
+
+    void ThreadPool::Start(const ThreadPoolOptions& options)
+    {
+        m_mode = options.mode;
+
+        // Pick the cores workers may run on
+        const CpuTopology& topology = CpuTopology::Get();
+        const std::vector<PhysicalCore>& allCores = topology.GetCores();
+        int mainCore = topology.FindCore(CpuTopology::GetCurrentCpu());
+
+        std::vector<const PhysicalCore*> cores;
+        for (int i = 0; i < static_cast<int>(allCores.size()); i++)
+        {
+            if (options.reserveMainCore && i == mainCore)
+                continue;
+            if (options.performanceCoresOnly && allCores[i].efficiency)
+                continue;
+            cores.push_back(&allCores[i]);
+        }
+
+        // Single core machines still get a worker, it just shares the main thread's core
+        if (cores.empty() && mainCore >= 0)
+            cores.push_back(&allCores[mainCore]);
+
+        int numThreads = options.numThreads > 0 ? options.numThreads : std::max(1, static_cast<int>(cores.size()));
+        if (options.pinThreads && numThreads > static_cast<int>(cores.size()))
+            Logger::EngineWarn("Thread pool has %d workers but only %d cores to pin them to, some workers will share a core", numThreads, static_cast<int>(cores.size()));
+
+        if (options.pinMainThread && mainCore >= 0 && !CpuTopology::PinCurrentThread(allCores[mainCore].cpus))
+            Logger::EngineWarn("Failed to pin the main thread to its core");
+
+        // Create the worker state before any thread can touch it
+        for (int i = 0; i < numThreads; i++)
+        {
+            m_workers.emplace_back(std::make_unique<Worker>());
+            Worker& worker = *m_workers.back();
+            worker.rng = 0x9E3779B9u * (i + 1);
+            worker.name = options.namePrefix + " " + std::to_string(i);
+            if (options.pinThreads && !cores.empty())
+                worker.cpus = cores[i % cores.size()]->cpus;
+        }
+
         for (int i = 0; i < numThreads; i++)
-            m_threads.emplace_back(std::thread(&ThreadPool::ThreadLoop, this));
+            m_threads.emplace_back(std::thread(&ThreadPool::ThreadLoop, this, i));
     }
 
-    void ThreadPool::Enqueue(const std::function<void()>& job, Priority priority)
+    void ThreadPool::Enqueue(Job job, Priority priority)
     {
-        // Enqueue the job
-        m_queues[static_cast<int>(priority)].enqueue(job);
-        // Wake up a worker thread to run the job
-        m_signal.enqueue(true);
+        int p = static_cast<int>(priority);
+        QueuedJob queued{ std::move(job), GetTimeNs() };
+
+        // Enqueue the job. Workers keep the jobs they spawn in their own queues
+        if (m_mode == SchedulingMode::WorkStealing && t_pool == this)
+        {
+            Worker& worker = *m_workers[t_workerIndex];
+            worker.queues[p].enqueue(worker.tokens[p], std::move(queued));
+        }
+        else
+            m_queues[p].enqueue(GetProducerTokens().tokens[p], std::move(queued));
+
+        // Wake up a worker thread to run the job if they are all asleep
+        WakeWorkers(1);
     }
 
-    void ThreadPool::ThreadLoop()
+    void ThreadPool::EnqueueBulk(std::span<Job> jobs, Priority priority)
     {
-        bool token;
-        while (true)
+        if (jobs.empty())
+            return;
+
+        int p = static_cast<int>(priority);
+        int64_t now = GetTimeNs();
+
+        // Reused between calls so bulk submission doesn't allocate once warm
+        thread_local std::vector<QueuedJob> batch;
+        batch.clear();
+        batch.reserve(jobs.size());
+        for (Job& job : jobs)
+            batch.push_back(QueuedJob{ std::move(job), now });
+
+        if (m_mode == SchedulingMode::WorkStealing && t_pool == this)
         {
-            // Wait for job to be enqueued
-            m_signal.wait_dequeue(token);
-            
-            // Stop early if necessary
-            if (m_shouldTerminate)
-                return;
+            Worker& worker = *m_workers[t_workerIndex];
+            worker.queues[p].enqueue_bulk(worker.tokens[p], std::make_move_iterator(batch.begin()), batch.size());
+        }
+        else
+            m_queues[p].enqueue_bulk(GetProducerTokens().tokens[p], std::make_move_iterator(batch.begin()), batch.size());
+
+        batch.clear();
+
+        WakeWorkers(static_cast<int>(jobs.size()));
+    }
+
+    ThreadPoolStats ThreadPool::GetStats() const
+    {
+        ThreadPoolStats stats;
+        for (int i = 0; i < static_cast<int>(Priority::Count); i++)
+        {
+            PriorityStats& priority = stats.priorities[i];
+            priority.queueDepth = m_queues[i].size_approx();
 
-            // Get job to run
-            std::function<void()> job;
-            bool found = false;
+            uint64_t totalWaitNs = 0;
+            uint64_t maxWaitNs = 0;
+            for (const std::unique_ptr<Worker>& worker : m_workers)
+            {
+                priority.queueDepth += worker->queues[i].size_approx();
+                priority.jobsRun += worker->jobsRun[i].load(std::memory_order_relaxed);
+                totalWaitNs += worker->totalWaitNs[i].load(std::memory_order_relaxed);
+                maxWaitNs = std::max(maxWaitNs, worker->maxWaitNs[i].load(std::memory_order_relaxed));
+            }
+
+            if (priority.jobsRun > 0)
+                priority.averageWaitMs = static_cast<double>(totalWaitNs) / priority.jobsRun / 1e6;
+            priority.maxWaitMs = static_cast<double>(maxWaitNs) / 1e6;
+        }
+
+        return stats;
+    }
 
+    void ThreadPool::ResetStats()
+    {
+        for (const std::unique_ptr<Worker>& worker : m_workers)
+        {
             for (int i = 0; i < static_cast<int>(Priority::Count); i++)
             {
-                if (m_queues[i].try_dequeue(job))
+                worker->jobsRun[i].store(0, std::memory_order_relaxed);
+                worker->totalWaitNs[i].store(0, std::memory_order_relaxed);
+                worker->maxWaitNs[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void ThreadPool::ThreadLoop(int workerIndex)
+    {
+        t_pool = this;
+        t_workerIndex = workerIndex;
+
+        Worker& worker = *m_workers[workerIndex];
+        CpuTopology::SetCurrentThreadName(worker.name);
+        if (!worker.cpus.empty() && !CpuTopology::PinCurrentThread(worker.cpus))
+            Logger::EngineWarn("Failed to pin %s to its core", worker.name.c_str());
+
+        QueuedJob job;
+        while (!m_shouldTerminate)
+        {
+            // Run jobs for as long as there are any
+            if (TryGetJob(workerIndex, job))
+            {
+                job.job();
+                job.job.Reset();
+                continue;
+            }
+
+            // Announce that this worker is going to sleep, then look once more
+            // Either this sees a job enqueued in the meantime, or its producer sees this worker sleeping and wakes it
+            m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (TryGetJob(workerIndex, job) || m_shouldTerminate)
+            {
+                m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+                if (job.job)
                 {
-                    found = true;
-                    break;
+                    job.job();
+                    job.job.Reset();
                 }
+                continue;
             }
 
-            // Run job if found
-            if (found && job)
-                job();
+            m_semaphore.wait();
+            m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void ThreadPool::WakeWorkers(int count)
+    {
+        // Pairs with the fence in ThreadLoop, so the job is visible to a worker that isn't counted as sleeping yet
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int sleeping = m_sleeping.load(std::memory_order_relaxed);
+        if (sleeping <= 0)
+            return;
+
+        // Wakeups that haven't been picked up yet will wake workers too
+        int pending = static_cast<int>(m_semaphore.availableApprox());
+        int wake = std::min(count, sleeping - pending);
+        if (wake > 0)
+            m_semaphore.signal(wake);
+    }
+
+    bool ThreadPool::TryGetJob(int workerIndex, QueuedJob& job)
+    {
+        // Look at the scheduled priority first, then fall back to the usual High to Low order
+        Worker& worker = *m_workers[workerIndex];
+        int first = PRIORITY_SCHEDULE[worker.picks++ % PRIORITY_SCHEDULE_LENGTH];
+        if (TryGetJob(workerIndex, first, job))
+            return true;
+
+        for (int i = 0; i < static_cast<int>(Priority::Count); i++)
+        {
+            if (i != first && TryGetJob(workerIndex, i, job))
+                return true;
+        }
+
+        return false;
+    }
+
+    bool ThreadPool::TryGetJob(int workerIndex, int priority, QueuedJob& job)
+    {
+        Worker& worker = *m_workers[workerIndex];
+        bool found = false;
+
+        // Own queue first since its jobs are most likely to be cache-warm
+        if (m_mode == SchedulingMode::WorkStealing)
+            found = worker.queues[priority].try_dequeue_from_producer(worker.tokens[priority], job);
+
+        if (!found)
+            found = m_queues[priority].try_dequeue(job);
+
+        if (!found && m_mode == SchedulingMode::WorkStealing)
+            found = TrySteal(workerIndex, priority, job);
+
+        if (found)
+            RecordWait(worker, priority, job);
+        return found;
+    }
+
+    bool ThreadPool::TrySteal(int workerIndex, int priority, QueuedJob& job)
+    {
+        int numWorkers = static_cast<int>(m_workers.size());
+        if (numWorkers < 2)
+            return false;
+
+        // Start at a random victim so thieves don't all hammer the same worker
+        uint32_t& rng = m_workers[workerIndex]->rng;
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        int start = static_cast<int>(rng % numWorkers);
+
+        for (int i = 0; i < numWorkers; i++)
+        {
+            int victim = (start + i) % numWorkers;
+            if (victim == workerIndex)
+                continue;
+
+            if (m_workers[victim]->queues[priority].try_dequeue(job))
+                return true;
         }
+
+        return false;
+    }
+
+    ThreadPool::ProducerTokens& ThreadPool::GetProducerTokens()
+    {
+        std::vector<ProducerCache::Entry>& entries = t_producerCache.entries;
+        for (ProducerCache::Entry& entry : entries)
+        {
+            if (entry.poolId == m_id)
+                return *entry.tokens;
+        }
+
+        // First enqueue from this thread. Forget pools that are gone while we're here
+        std::erase_if(entries, [](ProducerCache::Entry& entry) {
+            std::lock_guard<std::mutex> lock(entry.registry->mutex);
+            return !entry.registry->alive;
+        });
+
+        std::unique_ptr<ProducerTokens> tokens = std::make_unique<ProducerTokens>(m_queues);
+        ProducerTokens* result = tokens.get();
+        {
+            std::lock_guard<std::mutex> lock(m_producers->mutex);
+            m_producers->tokens.emplace(result, std::move(tokens));
+        }
+
+        entries.push_back({ m_id, result, m_producers });
+        return *result;
+    }
+
+    void ThreadPool::RecordWait(Worker& worker, int priority, const QueuedJob& job)
+    {
+        uint64_t waitNs = static_cast<uint64_t>(std::max<int64_t>(GetTimeNs() - job.enqueueTime, 0));
+        worker.jobsRun[priority].fetch_add(1, std::memory_order_relaxed);
+        worker.totalWaitNs[priority].fetch_add(waitNs, std::memory_order_relaxed);
+        if (waitNs > worker.maxWaitNs[priority].load(std::memory_order_relaxed))
+            worker.maxWaitNs[priority].store(waitNs, std::memory_order_relaxed);
     }
 }
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "Test.h"
+
+#include <wv/threading/ThreadPool.h>
+#include <atomic>
+#include <new>
+
+using namespace WillowVox;
+
+// Every heap allocation in the process goes through these, on any thread
+namespace
+{
+    std::atomic<bool> g_counting = false;
+    std::atomic<uint64_t> g_allocations = 0;
+
+    void* CountedAllocate(std::size_t size, std::size_t alignment)
+    {
+        if (g_counting.load(std::memory_order_relaxed))
+            g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+        void* block = alignment > alignof(std::max_align_t)
+            ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+            : std::malloc(size ? size : 1);
+        if (!block)
+            throw std::bad_alloc();
+        return block;
+    }
+}
+
+void* operator new(std::size_t size) { return CountedAllocate(size, 0); }
+void* operator new[](std::size_t size) { return CountedAllocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return CountedAllocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return CountedAllocate(size, static_cast<std::size_t>(alignment)); }
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete[](void* block) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::size_t) noexcept { std::free(block); }
+void operator delete(void* block, std::align_val_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::align_val_t) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::size_t, std::align_val_t) noexcept { std::free(block); }
+
+namespace
+{
+    constexpr int JOB_COUNT = 50000;
+
+    // Enqueue JOB_COUNT small jobs from this thread and wait for them to run
+    // In work-stealing mode every job also spawns a child from its worker, which goes to the worker's own queue
+    void RunJobs(ThreadPool& pool, bool spawnChildren)
+    {
+        std::atomic<int> ran = 0;
+        int expected = spawnChildren ? JOB_COUNT * 2 : JOB_COUNT;
+        for (int i = 0; i < JOB_COUNT; i++)
+        {
+            pool.Enqueue([&pool, &ran, spawnChildren]() {
+                if (spawnChildren)
+                    pool.Enqueue([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+                ran.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+
+        while (ran.load(std::memory_order_relaxed) != expected)
+            std::this_thread::yield();
+    }
+
+    // Run the loop with every worker held up first, so the queues grow as large as they ever will,
+    // then run it the way it is measured
+    void Warm(ThreadPool& pool, bool spawnChildren)
+    {
+        std::atomic<bool> release = false;
+        std::atomic<int> held = 0;
+        for (int i = 0; i < pool.GetThreadCount(); i++)
+        {
+            pool.Enqueue([&]() {
+                held++;
+                while (!release)
+                    std::this_thread::yield();
+            });
+        }
+        while (held != pool.GetThreadCount())
+            std::this_thread::yield();
+
+        std::thread releaser([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            release = true;
+        });
+        RunJobs(pool, spawnChildren);
+        releaser.join();
+
+        for (int i = 0; i < 3; i++)
+            RunJobs(pool, spawnChildren);
+    }
+
+    void Measure(SchedulingMode mode, bool spawnChildren)
+    {
+        ThreadPool pool;
+        pool.Start(4, mode);
+        Warm(pool, spawnChildren);
+
+        g_allocations = 0;
+        g_counting = true;
+        RunJobs(pool, spawnChildren);
+        g_counting = false;
+
+        std::printf("%s%s: %llu allocations for %d jobs\n", mode == SchedulingMode::Shared ? "Shared" : "WorkStealing",
+            spawnChildren ? " with children" : "", static_cast<unsigned long long>(g_allocations.load()), JOB_COUNT);
+        WV_CHECK(g_allocations == 0);
+    }
+}
+
+// Once the queues and free lists are warm, enqueueing and running small jobs must not touch the heap
+int main()
+{
+    Measure(SchedulingMode::Shared, false);
+    Measure(SchedulingMode::WorkStealing, false);
+    Measure(SchedulingMode::WorkStealing, true);
+
+    std::printf("JobAllocationTest passed\n");
+    return 0;
+}
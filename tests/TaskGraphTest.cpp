@@ -0,0 +1,76 @@
+#include "Test.h"
+
+#include <wv/threading/TaskGraph.h>
+#include <memory>
+
+using namespace WillowVox;
+
+// Builds, runs and destroys many small graphs, so the last worker of a submission
+// often finishes while the graph that owned it is being destroyed
+int main()
+{
+    ThreadPool pool;
+    pool.Start(4);
+
+    for (int i = 0; i < 20000; i++)
+    {
+        std::atomic<int> ran = 0;
+        std::atomic<int> joinedAfter = -1;
+
+        auto graph = std::make_unique<TaskGraph>();
+        TaskGraph::NodeId root = graph->AddNode([&]() { ran++; });
+        TaskGraph::NodeId left = graph->AddNode([&]() { ran++; });
+        TaskGraph::NodeId right = graph->AddNode([&]() { ran++; });
+        TaskGraph::NodeId join = graph->AddNode([&]() { joinedAfter = ran.load(); ran++; });
+        graph->AddEdge(root, left);
+        graph->AddEdge(root, right);
+        graph->AddEdge(left, join);
+        graph->AddEdge(right, join);
+
+        graph->Submit(pool);
+        graph->Wait();
+        graph.reset();
+
+        WV_CHECK(ran == 4);
+        WV_CHECK(joinedAfter == 3);
+    }
+
+    // A graph is destroyed without waiting on it first, its destructor has to wait
+    for (int i = 0; i < 20000; i++)
+    {
+        std::atomic<int> ran = 0;
+        {
+            TaskGraph graph;
+            graph.AddNode([&]() { ran++; });
+            graph.AddNode([&]() { ran++; });
+            graph.Submit(pool);
+        }
+        WV_CHECK(ran == 2);
+    }
+
+    // Running the same graph again reuses it
+    TaskGraph graph;
+    std::atomic<int> ran = 0;
+    TaskGraph::NodeId first = graph.AddNode([&]() { ran++; });
+    TaskGraph::NodeId second = graph.AddNode([&]() { ran++; });
+    graph.AddEdge(first, second);
+    for (int i = 0; i < 1000; i++)
+    {
+        graph.Submit(pool);
+        graph.Wait();
+    }
+    WV_CHECK(ran == 2000);
+
+    // Failing to add a node can't be mistaken for the first node
+    std::atomic<bool> release = false;
+    TaskGraph running;
+    running.AddNode([&]() { while (!release) std::this_thread::yield(); });
+    running.Submit(pool);
+    WV_CHECK(running.AddNode([]() {}) == TaskGraph::INVALID_NODE);
+    release = true;
+    running.Wait();
+    WV_CHECK(running.GetNodeCount() == 1);
+
+    std::printf("TaskGraphTest passed\n");
+    return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the tests, which are plain executables run by ctest
+// A failed check prints where it failed and exits with a non-zero code
+#define WV_CHECK(condition)                                                                   \
+    do                                                                                        \
+    {                                                                                         \
+        if (!(condition))                                                                     \
+        {                                                                                     \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1);                                                                     \
+        }                                                                                     \
+    } while (0)
@@ -0,0 +1,119 @@
+// Packs an assets directory into one archive that AssetManager::MountArchive can map
+// Usage: AssetPacker <assets directory> <output archive>
+
+#include <wv/Hash.h>
+#include <wv/assets/AssetArchive.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace WillowVox;
+
+namespace
+{
+    struct PackedFile
+    {
+        std::filesystem::path path;
+        // Path relative to the assets directory, as the engine looks it up
+        std::string name;
+        ArchiveEntry entry;
+    };
+
+    uint64_t Align(uint64_t offset)
+    {
+        return (offset + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: AssetPacker <assets directory> <output archive>\n";
+        return 1;
+    }
+
+    std::filesystem::path root = argv[1];
+    if (!std::filesystem::is_directory(root))
+    {
+        std::cerr << "Not a directory: " << root.string() << "\n";
+        return 1;
+    }
+
+    // Collect every file and sort by hash, since the engine binary searches the table of contents
+    std::vector<PackedFile> files;
+    for (const std::filesystem::directory_entry& file : std::filesystem::recursive_directory_iterator(root))
+    {
+        if (!file.is_regular_file())
+            continue;
+
+        PackedFile packed;
+        packed.path = file.path();
+        packed.name = std::filesystem::relative(file.path(), root).generic_string();
+        packed.entry.hash = Hash64(packed.name);
+        packed.entry.size = file.file_size();
+        files.push_back(std::move(packed));
+    }
+
+    std::sort(files.begin(), files.end(), [](const PackedFile& a, const PackedFile& b) {
+        return a.entry.hash < b.entry.hash;
+    });
+
+    for (std::size_t i = 1; i < files.size(); i++)
+    {
+        if (files[i].entry.hash == files[i - 1].entry.hash)
+        {
+            std::cerr << "Hash collision between " << files[i - 1].name << " and " << files[i].name << "\n";
+            return 1;
+        }
+    }
+
+    // Lay out the file data after the table of contents
+    uint64_t offset = Align(sizeof(ArchiveHeader) + files.size() * sizeof(ArchiveEntry));
+    for (PackedFile& file : files)
+    {
+        file.entry.offset = offset;
+        offset = Align(offset + file.entry.size);
+    }
+
+    std::ofstream out(argv[2], std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Failed to open " << argv[2] << "\n";
+        return 1;
+    }
+
+    // The archive is written in the host's byte order, which is little-endian on every supported platform
+    ArchiveHeader header = { ArchiveHeader::MAGIC, ArchiveHeader::VERSION, static_cast<uint32_t>(files.size()), 0 };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const PackedFile& file : files)
+        out.write(reinterpret_cast<const char*>(&file.entry), sizeof(file.entry));
+
+    std::vector<char> contents;
+    for (const PackedFile& file : files)
+    {
+        // Pad up to the file's offset
+        uint64_t position = static_cast<uint64_t>(out.tellp());
+        std::vector<char> padding(file.entry.offset - position, 0);
+        out.write(padding.data(), padding.size());
+
+        std::ifstream in(file.path, std::ios::binary);
+        contents.resize(file.entry.size);
+        if (!in.read(contents.data(), contents.size()))
+        {
+            std::cerr << "Failed to read " << file.path.string() << "\n";
+            return 1;
+        }
+        out.write(contents.data(), contents.size());
+    }
+
+    if (!out)
+    {
+        std::cerr << "Failed to write " << argv[2] << "\n";
+        return 1;
+    }
+
+    std::cout << "Packed " << files.size() << " files into " << argv[2] << " (" << offset << " bytes)\n";
+    return 0;
+}